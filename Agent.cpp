@@ -0,0 +1,289 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <filesystem>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "header.hpp"
+
+namespace {
+
+struct AgentState {
+    std::shared_mutex mutex;
+    std::vector<PasswordData> passwords;
+    std::unordered_multimap<std::string, std::size_t> byName;
+    WebsiteIndex websites;
+    std::atomic<bool> running = true;
+    std::atomic<int> clients = 0;
+    std::atomic<std::chrono::steady_clock::rep> lastActivity = 0;
+};
+
+auto now() -> std::chrono::steady_clock::rep {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+auto formatRecord(const PasswordData& p, bool withPassword) -> std::string {
+    std::string line = p.name + '\t';
+    if (withPassword)
+        line += p.password.value() + '\t';
+    line += p.category + '\t' + p.website.value_or("") + '\t' + p.login.value_or("") + '\n';
+    return line;
+}
+
+auto contains(const std::string& text, const std::string& term) -> bool {
+    return text.find(term) != std::string::npos;
+}
+
+auto answer(AgentState& state, const std::string& request) -> std::string {
+    std::istringstream iss(request);
+    std::string command, argument;
+    iss >> command >> argument;
+
+    std::string response;
+    std::shared_lock lock(state.mutex);
+
+    if (command == "GET" && !argument.empty()) {
+        auto [first, last] = state.byName.equal_range(argument);
+        for (auto it = first; it != last; ++it)
+            response += formatRecord(state.passwords[it->second], true);
+    } else if (command == "SITE" && !argument.empty()) {
+        for (const PasswordData& p : state.websites.lookup(argument))
+            response += formatRecord(p, true);
+    } else if (command == "SEARCH" && !argument.empty()) {
+        for (const PasswordData& p : state.passwords) {
+            if (contains(p.name, argument) || contains(p.category, argument)
+                || contains(p.website.value_or(""), argument) || contains(p.login.value_or(""), argument))
+                response += formatRecord(p, true);
+        }
+    } else if (command == "LIST") {
+        for (const PasswordData& p : state.passwords)
+            response += formatRecord(p, false);
+    } else {
+        return "ERR unknown request\nEND\n";
+    }
+    return response + "END\n";
+}
+
+// MSG_NOSIGNAL turns a client that hung up into EPIPE instead of a SIGPIPE that would kill the agent.
+auto sendAll(int client, std::string_view data) -> bool {
+    for (std::size_t sent = 0; sent < data.size();) {
+        auto w = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        sent += w;
+    }
+    return true;
+}
+
+auto serveClient(AgentState& state, int client) -> void {
+    std::string pending;
+    char buffer[4096];
+
+    while (state.running) {
+        pollfd pfd{client, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) <= 0)
+            continue;
+        auto n = read(client, buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        pending.append(buffer, n);
+
+        std::size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string request = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            state.lastActivity = now();
+
+            std::string response = answer(state, request);
+            auto delivered = sendAll(client, response);
+            wipeString(response);
+            if (!delivered) {
+                close(client);
+                state.clients--;
+                return;
+            }
+        }
+    }
+    close(client);
+    state.clients--;
+}
+
+// The socket must live in a directory only this user can write to; otherwise another user could
+// bind the path first and pose as the agent.
+auto privateDirectory(const std::string& directory) -> bool {
+    struct stat info{};
+    if (lstat(directory.c_str(), &info) != 0 && errno == ENOENT)
+        mkdir(directory.c_str(), 0700);
+    return lstat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode) && info.st_uid == getuid()
+           && (info.st_mode & 077) == 0;
+}
+
+auto connectAgent(const std::string& path) -> int {
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (client >= 0 && connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+        return client;
+    auto error = errno;
+    if (client >= 0)
+        close(client);
+    errno = error;
+    return -1;
+}
+
+}
+
+auto agentSocketPath() -> std::string {
+    if (const char* path = std::getenv("PM_AGENT_SOCK"); path && *path)
+        return path;
+    if (const char* runtime = std::getenv("XDG_RUNTIME_DIR"); runtime && *runtime)
+        return std::string(runtime) + "/projektpjc.sock";
+    return "/tmp/projektpjc-" + std::to_string(getuid()) + "/agent.sock";
+}
+
+auto runAgent(const std::string& file, int idleTimeout) -> void {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        std::cout << ">>> Warning: could not lock agent memory (" << std::strerror(errno) << ").\n";
+    prctl(PR_SET_DUMPABLE, 0);
+
+    AgentState state;
+    state.passwords = loadVault(file, readPassword());
+    for (auto i = 0; i < state.passwords.size(); ++i) {
+        state.byName.emplace(state.passwords[i].name, i);
+        state.websites.insert(state.passwords[i]);
+    }
+
+    std::string path = agentSocketPath();
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    if (!privateDirectory(directory.empty() ? "." : directory)) {
+        std::cout << ">>> Refusing to listen on " << path << ": its directory must be owned by you with mode 0700.\n";
+        return;
+    }
+    // A socket that still answers belongs to a live agent; only a stale one is removed.
+    if (int probe = connectAgent(path); probe >= 0) {
+        close(probe);
+        std::cout << ">>> An agent is already running on " << path << ".\n";
+        return;
+    } else if (errno == ECONNREFUSED) {
+        unlink(path.c_str());
+    }
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    auto oldMask = umask(0077);
+    auto bound = bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    umask(oldMask);
+    struct stat socketInfo{};
+    if (server < 0 || bound != 0 || listen(server, 64) != 0 || stat(path.c_str(), &socketInfo) != 0) {
+        std::cout << ">>> Could not listen on " << path << ": " << std::strerror(errno) << '\n';
+        if (server >= 0)
+            close(server);
+        return;
+    }
+
+    std::cout << ">>> Agent unlocked " << state.passwords.size() << " password(s) in "
+              << secretArena().regionCount() << " locked region(s), listening on " << path
+              << " (idle timeout " << idleTimeout << " s).\n";
+
+    state.lastActivity = now();
+    auto timeout = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(idleTimeout)).count();
+    while (state.running) {
+        pollfd pfd{server, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) > 0) {
+            int client = accept(server, nullptr, nullptr);
+            if (client >= 0) {
+                ucred peer{};
+                socklen_t length = sizeof(peer);
+                if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &length) != 0 || peer.uid != getuid()) {
+                    close(client);
+                    continue;
+                }
+                state.lastActivity = now();
+                state.clients++;
+                std::thread(serveClient, std::ref(state), client).detach();
+            }
+        }
+        if (now() - state.lastActivity > timeout)
+            state.running = false;
+    }
+
+    close(server);
+    // The path is only removed while it is still this agent's socket, not one bound after it.
+    struct stat current{};
+    if (stat(path.c_str(), &current) == 0 && current.st_dev == socketInfo.st_dev && current.st_ino == socketInfo.st_ino)
+        unlink(path.c_str());
+    while (state.clients > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Every container holding secrets is wiped and emptied first; the passwords themselves are sealed
+    // in the arena, and wiping it under a live secret would hand its memory out twice.
+    std::unique_lock lock(state.mutex);
+    for (PasswordData& p : state.passwords)
+        wipeRecord(p);
+    state.passwords.clear();
+    while (!state.byName.empty())
+        wipeString(state.byName.extract(state.byName.begin()).key());
+    state.websites.clear();
+    secretArena().wipe();
+    std::cout << ">>> Agent idle for " << idleTimeout << " s, vault locked.\n";
+}
+
+auto agentQuery(const std::string& request) -> int {
+    std::string path = agentSocketPath();
+    int client = connectAgent(path);
+    if (client < 0) {
+        std::cerr << ">>> No agent running on " << path << ".\n";
+        return 1;
+    }
+
+    // Requests name the secrets they look for, so they only go to an agent run by this user.
+    ucred peer{};
+    socklen_t length = sizeof(peer);
+    if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &length) != 0 || peer.uid != getuid()) {
+        std::cerr << ">>> The agent on " << path << " is not run by this user.\n";
+        close(client);
+        return 1;
+    }
+
+    std::string line = request + '\n';
+    if (write(client, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+        close(client);
+        return 1;
+    }
+
+    std::string response;
+    char buffer[4096];
+    while (response != "END\n" && !response.ends_with("\nEND\n")) {
+        auto n = read(client, buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        response.append(buffer, n);
+    }
+    close(client);
+
+    if (response.ends_with("END\n"))
+        response.resize(response.size() - 4);
+    std::cout << response;
+    return response.starts_with("ERR") ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+#include <iostream>
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include "header.hpp"
+
+namespace {
+
+constexpr std::size_t regionSize = 1 << 20;
+constexpr std::size_t alignment = 16;
+constexpr std::size_t leaseSize = 64 << 10;
+
+auto roundUp(std::size_t size) -> std::size_t {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+auto zero(void* p, std::size_t size) -> void {
+    volatile char* bytes = static_cast<char*>(p);
+    for (std::size_t i = 0; i < size; ++i)
+        bytes[i] = 0;
+}
+
+thread_local SecretArena::Lease* activeLease = nullptr;
+
+}
+
+SecretArena::Lease::Lease(SecretArena& arena) : arena(arena), previous(activeLease) {
+    activeLease = this;
+}
+
+SecretArena::Lease::~Lease() {
+    activeLease = previous;
+    arena.giveBack(*this);
+}
+
+SecretArena::~SecretArena() {
+    std::lock_guard lock(mutex);
+    reset();
+    for (const Region& region : regions)
+        munmap(region.base, region.size);
+}
+
+auto SecretArena::allocate(std::size_t size) -> void* {
+    size = roundUp(size == 0 ? 1 : size);
+    if (Lease* lease = activeLease; lease && &lease->arena == this && size <= leaseSize / 16) {
+        if (lease->epoch != epoch || static_cast<std::size_t>(lease->end - lease->next) < size)
+            refill(*lease);
+        void* p = lease->next;
+        lease->next += size;
+        live.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+    std::lock_guard lock(mutex);
+
+    void* p = nullptr;
+    auto sizeClass = size / alignment;
+    if (sizeClass < freeLists.size() && !freeLists[sizeClass].empty()) {
+        p = freeLists[sizeClass].back();
+        freeLists[sizeClass].pop_back();
+    } else if (sizeClass >= freeLists.size()) {
+        // The smallest free block that fits is split and its rest, already zero, stays free, so
+        // secrets of varying sizes reuse the locked memory instead of growing it.
+        auto fit = largeBlocks.end();
+        for (auto it = largeBlocks.begin(); it != largeBlocks.end(); ++it) {
+            if (it->second >= size && (fit == largeBlocks.end() || it->second < fit->second))
+                fit = it;
+        }
+        if (fit != largeBlocks.end()) {
+            auto [block, blockSize] = *fit;
+            largeBlocks.erase(fit);
+            p = block;
+            if (blockSize > size)
+                release(block + size, blockSize - size);
+        }
+    }
+    if (!p)
+        p = bump(size);
+    live.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+auto SecretArena::bump(std::size_t size) -> void* {
+    while (current < regions.size() && regions[current].size - regions[current].used < size)
+        ++current;
+    if (current == regions.size())
+        addRegion(size);
+    Region& region = regions[current];
+    void* p = region.base + region.used;
+    region.used += size;
+    return p;
+}
+
+auto SecretArena::refill(Lease& lease) -> void {
+    if (lease.epoch == epoch)
+        giveBack(lease);
+    std::lock_guard lock(mutex);
+    lease.next = static_cast<char*>(bump(leaseSize));
+    lease.end = lease.next + leaseSize;
+    lease.epoch = epoch;
+}
+
+auto SecretArena::giveBack(Lease& lease) -> void {
+    std::lock_guard lock(mutex);
+    if (lease.epoch != epoch || lease.next == lease.end)
+        return;
+
+    // The unused rest is still zero: it goes back to its region if nothing was bumped after it,
+    // otherwise it is cut into blocks for the free lists.
+    for (Region& region : regions) {
+        if (lease.end == region.base + region.used) {
+            region.used -= lease.end - lease.next;
+            lease.next = lease.end;
+            return;
+        }
+    }
+    constexpr std::size_t largest = (std::tuple_size_v<decltype(freeLists)> - 1) * alignment;
+    for (std::size_t rest = lease.end - lease.next; rest > 0;) {
+        auto size = std::min(rest, largest);
+        freeLists[size / alignment].push_back(lease.next);
+        lease.next += size;
+        rest -= size;
+    }
+}
+
+auto SecretArena::deallocate(void* p, std::size_t size) -> void {
+    size = roundUp(size == 0 ? 1 : size);
+    zero(p, size);
+    live.fetch_sub(1, std::memory_order_relaxed);
+    std::lock_guard lock(mutex);
+
+    auto sizeClass = size / alignment;
+    if (sizeClass < freeLists.size())
+        freeLists[sizeClass].push_back(p);
+    else
+        release(p, size);
+}
+
+// Large blocks, and what is left of them after a split however small, are kept by address and joined
+// with free neighbours, so splitting does not leave the memory in ever smaller pieces. A block at
+// the end of its region goes back to the region.
+auto SecretArena::release(void* p, std::size_t size) -> void {
+    auto block = static_cast<char*>(p);
+    auto next = largeBlocks.lower_bound(block);
+    if (next != largeBlocks.end() && block + size == next->first) {
+        size += next->second;
+        next = largeBlocks.erase(next);
+    }
+    if (next != largeBlocks.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == block) {
+            block = previous->first;
+            size += previous->second;
+            largeBlocks.erase(previous);
+        }
+    }
+    for (Region& region : regions) {
+        if (block + size == region.base + region.used && block >= region.base) {
+            region.used -= size;
+            return;
+        }
+    }
+    largeBlocks.emplace(block, size);
+}
+
+auto SecretArena::wipe() -> void {
+    std::lock_guard lock(mutex);
+    if (auto count = live.load(); count > 0)
+        throw std::logic_error("secret arena wiped while " + std::to_string(count) + " block(s) are still in use");
+    reset();
+}
+
+auto SecretArena::reset() -> void {
+    for (Region& region : regions) {
+        zero(region.base, region.used);
+        region.used = 0;
+    }
+    for (auto& list : freeLists)
+        list.clear();
+    largeBlocks.clear();
+    current = 0;
+    ++epoch;
+}
+
+auto SecretArena::regionCount() -> std::size_t {
+    std::lock_guard lock(mutex);
+    return regions.size();
+}
+
+auto SecretArena::addRegion(std::size_t minimum) -> void {
+    auto size = std::max(regionSize, roundUp(minimum));
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        throw std::bad_alloc();
+
+    if (mlock(base, size) != 0 && !warned) {
+        std::cout << ">>> Warning: could not lock memory for secrets (" << std::strerror(errno) << ").\n";
+        warned = true;
+    }
+#ifdef MADV_DONTDUMP
+    madvise(base, size, MADV_DONTDUMP);
+#endif
+    regions.push_back(Region{static_cast<char*>(base), size, 0});
+}
+
+auto secretArena() -> SecretArena& {
+    static SecretArena arena;
+    return arena;
+}
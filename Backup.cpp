@@ -0,0 +1,445 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include "header.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string manifestTag = "[BACKUP] ";
+constexpr std::size_t chunkIdSize = 16;
+
+// Masks of the normalized chunking: cutting is harder before the average size and easier after it,
+// which keeps most chunks close to the average.
+constexpr std::uint64_t strictMask = 0x0000d9f003530000;
+constexpr std::uint64_t looseMask = 0x0000d90003530000;
+
+const auto gearTable = [] {
+    std::array<std::uint64_t, 256> table{};
+    std::uint64_t state = 0;
+    for (auto& value : table) {
+        auto z = state += 0x9e3779b97f4a7c15;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        value = z ^ (z >> 31);
+    }
+    return table;
+}();
+
+struct BackupStore {
+    fs::path root;
+    std::string idKey;
+    std::string chunkKey;
+    std::string manifestKey;
+};
+
+struct Manifest {
+    std::uint64_t number = 0;
+    std::string timestamp;
+    std::size_t records = 0;
+    std::size_t bytes = 0;
+    std::size_t chunks = 0;
+    std::size_t newChunks = 0;
+    std::size_t newBytes = 0;
+    std::string line;
+    std::string blob;
+};
+
+// Length of the first chunk of data: the Gear hash depends on the last 64 bytes only, so an edit
+// moves the cut points around it and the chunks after it are found again.
+auto cutPoint(std::string_view data) -> std::size_t {
+    if (data.size() <= minimumBackupChunk)
+        return data.size();
+    auto limit = std::min(data.size(), maximumBackupChunk);
+    auto normal = std::min(limit, averageBackupChunk);
+
+    std::uint64_t hash = 0;
+    auto i = minimumBackupChunk;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + gearTable[(unsigned char) data[i]];
+        if ((hash & strictMask) == 0)
+            return i + 1;
+    }
+    for (; i < limit; ++i) {
+        hash = (hash << 1) + gearTable[(unsigned char) data[i]];
+        if ((hash & looseMask) == 0)
+            return i + 1;
+    }
+    return limit;
+}
+
+auto chunkPath(const BackupStore& store, const std::string& id) -> fs::path {
+    std::string name = toHex(id);
+    return store.root / "chunks" / name.substr(0, 2) / name;
+}
+
+auto manifestPath(const BackupStore& store, std::uint64_t number) -> fs::path {
+    return store.root / "manifests" / std::to_string(number);
+}
+
+auto readFile(const fs::path& path) -> std::string {
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+        throw std::runtime_error("cannot read " + path.string());
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+    return buffer.str();
+}
+
+auto storeKeys(const fs::path& root, const std::string& storeKey) -> BackupStore {
+    return BackupStore{root, hmacSha256(storeKey, "chunk id"), hmacSha256(storeKey, "chunk"), hmacSha256(storeKey, "manifest")};
+}
+
+// The STORE file holds a header and a random store key sealed under the key the header derives from
+// the password. Chunks and manifests use the store key, so a new password only reseals this file.
+auto writeStoreFile(const fs::path& root, const std::string& password, std::string_view storeKey) -> void {
+    std::string header = newVaultHeader();
+    std::string wrapped = sealSecret(makeCipherEngine(header, password)->recordKey(), 0, storeKey);
+    fileModify((root / "STORE").string(), header + '\n' + toHex(wrapped) + '\n');
+}
+
+auto readStoreKey(const fs::path& root, const std::string& password) -> SecureString {
+    std::istringstream lines(readFile(root / "STORE"));
+    std::string header, wrapped;
+    std::getline(lines, header);
+    std::getline(lines, wrapped);
+    return openSecret(makeCipherEngine(header, password)->recordKey(), fromHex(wrapped));
+}
+
+// Opens the store of a vault, or creates it with a new store key.
+auto openStore(const std::string& file, const std::string& password, bool create) -> BackupStore {
+    fs::path root = backupPath(file);
+    if (fs::exists(root / "STORE"))
+        return storeKeys(root, std::string(std::string_view(readStoreKey(root, password))));
+    if (!create)
+        throw std::runtime_error("no backups of " + file);
+
+    fs::create_directories(root / "chunks");
+    fs::create_directories(root / "manifests");
+    std::string storeKey = randomBytes(32);
+    writeStoreFile(root, password, storeKey);
+    return storeKeys(root, storeKey);
+}
+
+auto parseManifest(const fs::path& path) -> Manifest {
+    std::istringstream lines(readFile(path));
+    Manifest manifest;
+    std::string hex, date, time;
+    std::getline(lines, manifest.line);
+    std::getline(lines, hex);
+    if (!manifest.line.starts_with(manifestTag))
+        throw std::runtime_error("corrupted manifest " + path.string());
+
+    std::istringstream fields(manifest.line.substr(manifestTag.size()));
+    fields >> manifest.number >> date >> time >> manifest.records >> manifest.bytes >> manifest.chunks >> manifest.newChunks
+           >> manifest.newBytes;
+    manifest.timestamp = date + " " + time;
+    manifest.blob = fromHex(hex);
+    return manifest;
+}
+
+auto listManifests(const BackupStore& store) -> std::vector<Manifest> {
+    std::vector<Manifest> manifests;
+    if (!fs::exists(store.root / "manifests"))
+        return manifests;
+    for (const auto& entry : fs::directory_iterator(store.root / "manifests")) {
+        std::string name = entry.path().filename().string();
+        if (!name.empty() && std::ranges::all_of(name, [](char c) { return c >= '0' && c <= '9'; }))
+            manifests.push_back(parseManifest(entry.path()));
+    }
+    std::ranges::sort(manifests, {}, &Manifest::number);
+    return manifests;
+}
+
+auto findManifest(const BackupStore& store, std::uint64_t number) -> Manifest {
+    if (!fs::exists(manifestPath(store, number)))
+        throw std::runtime_error("backup " + std::to_string(number) + " not found");
+    return parseManifest(manifestPath(store, number));
+}
+
+auto storeChunk(const BackupStore& store, const std::string& id, std::string_view chunk) -> std::size_t {
+    // A flag byte tells whether the chunk was worth compressing.
+    std::string text(chunk);
+    std::string packed = compressText(text);
+    std::string payload = packed.size() < chunk.size() ? 'C' + packed : 'R' + text;
+    wipeString(text);
+    wipeString(packed);
+
+    // The nonce comes from the id, which is unique per content, so equal chunks seal to equal files.
+    std::uint64_t counter;
+    std::memcpy(&counter, id.data(), sizeof counter);
+    std::string blob = sealSecret(store.chunkKey, counter, payload);
+    wipeString(payload);
+
+    fs::path path = chunkPath(store, id);
+    fs::create_directories(path.parent_path());
+    fs::path temporary = path.string() + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        output.write(blob.data(), (std::streamsize) blob.size());
+        if (!output)
+            throw std::runtime_error("cannot write " + temporary.string());
+    }
+    fs::rename(temporary, path);
+    return blob.size();
+}
+
+// Opens one chunk and hands its text to onText; returns the number of bytes of text.
+auto readChunk(const BackupStore& store, const std::string& id, const std::function<void(std::string_view)>& onText) -> std::size_t {
+    SecureString payload = openSecret(store.chunkKey, readFile(chunkPath(store, id)));
+    if (payload.empty())
+        throw std::runtime_error("corrupted chunk " + toHex(id));
+    if (payload.front() == 'C') {
+        std::string packed(std::string_view(payload).substr(1));
+        std::string text = decompressText(packed);
+        auto size = text.size();
+        onText(text);
+        wipeString(packed);
+        wipeString(text);
+        return size;
+    }
+    onText(std::string_view(payload).substr(1));
+    return payload.size() - 1;
+}
+
+// The ids of the chunks of a backup, in order, after checking the sealed copy of the manifest line.
+auto chunkIds(const BackupStore& store, const Manifest& manifest) -> std::string {
+    SecureString list = openSecret(store.manifestKey, manifest.blob);
+    std::string_view ids(list);
+    if (!ids.starts_with(manifest.line + '\n'))
+        throw std::runtime_error("manifest " + std::to_string(manifest.number) + " was modified");
+    ids.remove_prefix(manifest.line.size() + 1);
+    if (ids.size() != manifest.chunks * chunkIdSize)
+        throw std::runtime_error("corrupted manifest " + std::to_string(manifest.number));
+    return std::string(ids);
+}
+
+// Streams the content of a backup to onText, one chunk at a time and in order.
+auto readBackup(const BackupStore& store, const Manifest& manifest,
+                const std::function<void(std::string_view)>& onText) -> void {
+    std::string ids = chunkIds(store, manifest);
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < manifest.chunks; ++i) {
+        std::string id = ids.substr(i * chunkIdSize, chunkIdSize);
+        try {
+            bytes += readChunk(store, id, onText);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("chunk " + std::to_string(i) + " of backup " + std::to_string(manifest.number) + " ("
+                                     + toHex(id) + ") is damaged or missing: " + e.what());
+        }
+    }
+    if (bytes != manifest.bytes)
+        throw std::runtime_error("backup " + std::to_string(manifest.number) + " is incomplete");
+}
+
+auto syncStore(const fs::path& root) -> void {
+    int fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        syncfs(fd);
+        close(fd);
+    }
+}
+
+auto listBackups(const std::string& file) -> void {
+    // Listing reads only the plain manifest lines, so no keys are needed.
+    VaultLock lock(file, VaultLock::SHARED);
+    BackupStore store{backupPath(file), {}, {}, {}};
+    std::vector<Manifest> manifests = listManifests(store);
+    if (manifests.empty()) {
+        std::cout << ">>> No backups of " << file << ".\n";
+        return;
+    }
+
+    std::size_t fullSize = 0, storeSize = 0;
+    std::cout << ">>> Backups of " << file << ":\n";
+    for (const Manifest& manifest : manifests) {
+        std::cout << std::setw(6) << manifest.number << "  " << manifest.timestamp << "  " << std::setw(8) << manifest.records
+                  << " password(s)  " << std::setw(6) << manifest.chunks << " chunk(s)  " << std::setw(6)
+                  << manifest.newChunks << " new, " << manifest.newBytes << " bytes\n";
+        fullSize += fs::exists(file) ? fs::file_size(file) : 0;
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(store.root)) {
+        if (entry.is_regular_file())
+            storeSize += entry.file_size();
+    }
+    if (fullSize > 0)
+        std::cout << ">>> Backups take " << storeSize << " bytes, " << std::fixed << std::setprecision(1)
+                  << 100.0 * storeSize / fullSize << "% of " << manifests.size() << " full copies.\n" << std::defaultfloat;
+}
+
+}
+
+auto backupPath(const std::string& file) -> std::string {
+    return file + ".backup";
+}
+
+auto backupVault(const std::string& file, const std::string& password, const std::string& data) -> std::uint64_t {
+    BackupStore store;
+    try {
+        store = openStore(file, password, true);
+    } catch (const std::exception& e) {
+        setAside(backupPath(file), "Backups", e.what());
+        store = openStore(file, password, true);
+    }
+
+    std::vector<Manifest> manifests = listManifests(store);
+    std::uint64_t number = manifests.empty() ? 1 : manifests.back().number + 1;
+
+    std::string ids;
+    std::size_t chunks = 0, newChunks = 0, newBytes = 0;
+    for (std::string_view rest = data; !rest.empty();) {
+        std::string_view chunk = rest.substr(0, cutPoint(rest));
+        rest.remove_prefix(chunk.size());
+        std::string id = hmacSha256(store.idKey, std::string(chunk)).substr(0, chunkIdSize);
+        if (!fs::exists(chunkPath(store, id))) {
+            newBytes += storeChunk(store, id, chunk);
+            ++newChunks;
+        }
+        ids += id;
+        ++chunks;
+    }
+
+    // The chunks must be on disk before a manifest refers to them; one syncfs covers all of them.
+    if (newChunks > 0)
+        syncStore(store.root);
+
+    auto records = std::ranges::count(data, '\n');
+    std::string line = manifestTag + std::to_string(number) + ' ' + currentTimestamp() + ' ' + std::to_string(records) + ' '
+                       + std::to_string(data.size()) + ' ' + std::to_string(chunks) + ' ' + std::to_string(newChunks) + ' '
+                       + std::to_string(newBytes);
+    // The sealed part repeats the visible line, so the listed numbers cannot be changed unnoticed. The store
+    // key lives as long as the store and a manifest number can come back, so the nonce is random.
+    fileModify(manifestPath(store, number).string(),
+               line + '\n' + toHex(sealSecret(store.manifestKey, line + '\n' + ids)) + '\n');
+    std::cout << ">>> Backup " << number << ": " << newChunks << " of " << chunks << " chunk(s) new, " << newBytes
+              << " bytes stored.\n";
+    return number;
+}
+
+auto rekeyBackups(const std::string& file, const std::string& oldPassword, const std::string& newPassword) -> std::string {
+    fs::path root = backupPath(file);
+    if (!fs::exists(root / "STORE"))
+        return "";
+    BackupStore old = storeKeys(root, std::string(std::string_view(readStoreKey(root, oldPassword))));
+
+    // Resealing the old store key would let an old STORE file and the old password open every backup,
+    // so the store is rebuilt next to the old one under a new store key, with new chunk ids.
+    fs::path staged = root.string() + ".rekey";
+    fs::remove_all(staged);
+    fs::create_directories(staged / "chunks");
+    fs::create_directories(staged / "manifests");
+    std::string storeKey = randomBytes(32);
+    BackupStore fresh = storeKeys(staged, storeKey);
+
+    // A half built store is removed again, so a failed re-key leaves only the old store behind.
+    try {
+        std::unordered_map<std::string, std::string> renamed;
+        for (const Manifest& manifest : listManifests(old)) {
+            std::string oldIds = chunkIds(old, manifest), ids;
+            for (std::size_t i = 0; i < manifest.chunks; ++i) {
+                std::string id = oldIds.substr(i * chunkIdSize, chunkIdSize);
+                auto [it, added] = renamed.try_emplace(id);
+                if (added) {
+                    readChunk(old, id, [&](std::string_view text) {
+                        std::string chunk(text);
+                        it->second = hmacSha256(fresh.idKey, chunk).substr(0, chunkIdSize);
+                        storeChunk(fresh, it->second, chunk);
+                        wipeString(chunk);
+                    });
+                }
+                ids += it->second;
+            }
+            fileModify(manifestPath(fresh, manifest.number).string(),
+                       manifest.line + '\n' + toHex(sealSecret(fresh.manifestKey, manifest.line + '\n' + ids)) + '\n');
+        }
+        syncStore(staged);
+        writeStoreFile(staged, newPassword, storeKey);
+    } catch (...) {
+        wipeString(storeKey);
+        fs::remove_all(staged);
+        throw;
+    }
+    wipeString(storeKey);
+    return staged.string();
+}
+
+auto backupRecords(const std::string& file, const std::string& password, std::uint64_t number) -> std::vector<PasswordData> {
+    // Saves add chunks and manifests under the exclusive lock, so a reader never sees a store half written.
+    VaultLock lock(file, VaultLock::SHARED);
+    BackupStore store = openStore(file, password, false);
+    Manifest manifest = findManifest(store, number);
+
+    // Records are parsed as the chunks arrive; only a line cut by a chunk boundary is carried over.
+    std::vector<PasswordData> passwords;
+    passwords.reserve(manifest.records);
+    SecureString partial;
+    readBackup(store, manifest, [&](std::string_view text) {
+        for (auto newline = text.find('\n'); newline != std::string_view::npos; newline = text.find('\n')) {
+            if (partial.empty()) {
+                passwords.push_back(parseLine(text.substr(0, newline)));
+            } else {
+                partial.append(text.substr(0, newline));
+                passwords.push_back(parseLine(partial));
+                partial.clear();
+            }
+            text.remove_prefix(newline + 1);
+        }
+        partial.append(text);
+    });
+    if (!partial.empty())
+        passwords.push_back(parseLine(partial));
+    return passwords;
+}
+
+auto backupCommand(const std::vector<std::string>& args) -> void {
+    if (args.size() < 2)
+        throw std::runtime_error("usage: --backup VAULT [create|show N|restore N]");
+    const std::string& file = args[1];
+
+    if (args.size() < 3) {
+        listBackups(file);
+        return;
+    }
+
+    std::string password = readPassword();
+    auto start = std::chrono::steady_clock::now();
+    auto ms = [&start] { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+    if (args[2] == "create") {
+        VaultLock lock(file, VaultLock::EXCLUSIVE);
+        std::vector<PasswordData> passwords = readPipeline(file, password);
+        start = std::chrono::steady_clock::now();
+        std::string plain = serializePasswords(passwords);
+        backupVault(file, password, plain);
+        wipeString(plain);
+        std::cout << ">>> Backed up " << passwords.size() << " password(s) in " << ms() << " ms.\n";
+    } else if ((args[2] == "show" || args[2] == "restore") && args.size() > 3) {
+        std::uint64_t number = std::stoull(args[3]);
+        std::vector<PasswordData> passwords = backupRecords(file, password, number);
+        std::cout << ">>> Read backup " << number << ": " << passwords.size() << " password(s) in " << ms() << " ms.\n";
+        if (args[2] == "show") {
+            for (const PasswordData& p : passwords)
+                printPassword(p);
+        } else {
+            passwordsSave(passwords, file, password);
+            std::cout << ">>> Restored backup " << number << " of " << file << ".\n";
+        }
+    } else {
+        throw std::runtime_error("unknown backup command " + args[2]);
+    }
+    secretArena().wipe();
+}
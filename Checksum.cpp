@@ -0,0 +1,308 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <filesystem>
+#include "header.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define PM_HAVE_SSE42_KERNEL 1
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string blocksTag = "[BLOCKS] ";
+
+// Slicing-by-8 tables for the reflected Castagnoli polynomial.
+const auto crcTables = [] {
+    std::array<std::array<std::uint32_t, 256>, 8> tables{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        auto crc = i;
+        for (auto bit = 0; bit < 8; ++bit)
+            crc = crc & 1 ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+        tables[0][i] = crc;
+    }
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        for (auto t = 1; t < 8; ++t)
+            tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xff];
+    }
+    return tables;
+}();
+
+auto crc32cSoftware(std::uint32_t crc, const unsigned char* data, std::size_t size) -> std::uint32_t {
+    const auto& t = crcTables;
+    while (size >= 8) {
+        std::uint32_t low, high;
+        std::memcpy(&low, data, 4);
+        std::memcpy(&high, data + 4, 4);
+        low ^= crc;
+        crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24]
+              ^ t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0)
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xff];
+    return crc;
+}
+
+#ifdef PM_HAVE_SSE42_KERNEL
+__attribute__((target("sse4.2")))
+auto crc32cSse42(std::uint32_t crc, const unsigned char* data, std::size_t size) -> std::uint32_t {
+    std::uint64_t wide = crc;
+    while (size >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data, 8);
+        wide = _mm_crc32_u64(wide, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = (std::uint32_t) wide;
+    while (size-- > 0)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+
+auto haveSse42() -> bool {
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+}
+#endif
+
+auto hexDigit(char c) -> std::uint32_t {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    throw std::runtime_error("corrupted block table");
+}
+
+// Memory map of a whole file, for reading it without copying.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& file) {
+        int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("cannot open " + file);
+        struct stat info{};
+        fstat(fd, &info);
+        size = info.st_size;
+        if (size > 0)
+            base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+            throw std::runtime_error("cannot map " + file);
+        if (size > 0)
+            madvise(base, size, MADV_SEQUENTIAL);
+    }
+
+    ~MappedFile() {
+        if (size > 0)
+            munmap(base, size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    auto text() const -> std::string_view {
+        return size > 0 ? std::string_view(static_cast<const char*>(base), size) : std::string_view();
+    }
+
+private:
+    void* base = nullptr;
+    std::size_t size = 0;
+};
+
+}
+
+auto crc32c(std::string_view data, std::uint32_t crc) -> std::uint32_t {
+    auto bytes = reinterpret_cast<const unsigned char*>(data.data());
+#ifdef PM_HAVE_SSE42_KERNEL
+    if (haveSse42())
+        return ~crc32cSse42(~crc, bytes, data.size());
+#endif
+    return ~crc32cSoftware(~crc, bytes, data.size());
+}
+
+auto checksumKernel() -> std::string {
+#ifdef PM_HAVE_SSE42_KERNEL
+    if (haveSse42())
+        return "sse4.2";
+#endif
+    return "software";
+}
+
+auto makeBlockTable(std::string_view body) -> std::string {
+    static constexpr char digits[] = "0123456789abcdef";
+    auto count = (body.size() + checksumBlockSize - 1) / checksumBlockSize;
+    std::string line = blocksTag + "size=" + std::to_string(checksumBlockSize) + " length=" + std::to_string(body.size())
+                       + " crc32c=";
+    for (std::size_t i = 0; i < count; ++i) {
+        auto crc = crc32c(body.substr(i * checksumBlockSize, checksumBlockSize));
+        for (auto shift = 28; shift >= 0; shift -= 4)
+            line += digits[(crc >> shift) & 15];
+    }
+    return line;
+}
+
+auto isBlockTable(std::string_view line) -> bool {
+    return line.starts_with(blocksTag);
+}
+
+auto parseBlockTable(const std::string& line) -> BlockTable {
+    BlockTable table;
+    std::string crcs;
+    for (std::string_view rest = std::string_view(line).substr(blocksTag.size()); !rest.empty();) {
+        auto end = std::min(rest.find(' '), rest.size());
+        std::string_view field = rest.substr(0, end);
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+        if (field.starts_with("size="))
+            table.blockSize = std::stoull(std::string(field.substr(5)));
+        else if (field.starts_with("length="))
+            table.length = std::stoull(std::string(field.substr(7)));
+        else if (field.starts_with("crc32c="))
+            crcs = field.substr(7);
+    }
+
+    if (table.blockSize == 0 || crcs.size() % 8 != 0
+        || crcs.size() / 8 != (table.length + table.blockSize - 1) / table.blockSize)
+        throw std::runtime_error("corrupted block table");
+    for (std::size_t i = 0; i < crcs.size(); i += 8) {
+        std::uint32_t crc = 0;
+        for (auto j = 0; j < 8; ++j)
+            crc = crc << 4 | hexDigit(crcs[i + j]);
+        table.checksums.push_back(crc);
+    }
+    return table;
+}
+
+BlockVerifier::BlockVerifier(BlockTable table) : table(std::move(table)) {}
+
+auto BlockVerifier::update(std::string_view data) -> void {
+    while (!data.empty()) {
+        if (block >= table.checksums.size())
+            throw std::runtime_error("vault damaged after its last block (" + std::to_string(table.length)
+                                     + " bytes expected)");
+        auto blockEnd = std::min(table.blockSize, table.length - block * table.blockSize);
+        auto take = std::min(data.size(), blockEnd - filled);
+        crc = crc32c(data.substr(0, take), crc);
+        filled += take;
+        data.remove_prefix(take);
+        if (filled == blockEnd)
+            check();
+    }
+}
+
+auto BlockVerifier::finish() -> void {
+    if (block < table.checksums.size())
+        throw std::runtime_error("vault truncated in block " + std::to_string(block) + " of "
+                                 + std::to_string(table.checksums.size()) + " (byte " + std::to_string(block * table.blockSize + filled)
+                                 + " of " + std::to_string(table.length) + ")");
+}
+
+auto BlockVerifier::check() -> void {
+    if (crc != table.checksums[block])
+        throw std::runtime_error("vault damaged in block " + std::to_string(block) + " of "
+                                 + std::to_string(table.checksums.size()) + " (bytes " + std::to_string(block * table.blockSize)
+                                 + "-" + std::to_string(block * table.blockSize + filled - 1) + " of the body)");
+    ++block;
+    filled = 0;
+    crc = 0;
+}
+
+auto verifyVault(const std::string& file) -> std::vector<std::size_t> {
+    MappedFile mapped(file);
+    std::string_view text = mapped.text();
+
+    auto nextLine = [&text]() {
+        auto newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        return line;
+    };
+    if (!nextLine().starts_with(vaultHeaderTag))
+        throw std::runtime_error("not a vault, or a legacy vault without checksums");
+    std::string_view tableLine = nextLine();
+    if (!isBlockTable(tableLine))
+        throw std::runtime_error("no block table, save the vault once to add one");
+    BlockTable table = parseBlockTable(std::string(tableLine));
+    if (isSecretsSection(text))
+        parseSecretsSection(nextLine());
+    std::string_view body = text.substr(0, std::min(text.find('\n'), text.size()));
+
+    // Blocks are independent, so the threads take interleaved blocks and only the damaged ones are collected.
+    std::vector<std::size_t> damaged;
+    std::mutex mutex;
+    auto threadCount = std::max<std::size_t>(1, std::min<std::size_t>(std::thread::hardware_concurrency(),
+                                                                       table.checksums.size()));
+    auto work = [&](std::size_t first) {
+        for (auto i = first; i < table.checksums.size(); i += threadCount) {
+            auto offset = i * table.blockSize;
+            auto expected = std::min(table.blockSize, table.length - offset);
+            std::string_view block = offset < body.size() ? body.substr(offset, expected) : std::string_view();
+            if (block.size() != expected || crc32c(block) != table.checksums[i]) {
+                std::lock_guard<std::mutex> lock(mutex);
+                damaged.push_back(i);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < threadCount; ++t)
+        threads.emplace_back(work, t);
+    work(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    std::ranges::sort(damaged);
+    if (body.size() > table.length)
+        damaged.push_back(table.checksums.size());
+    return damaged;
+}
+
+auto verifyCommand(const std::vector<std::string>& args) -> int {
+    if (args.size() < 2)
+        throw std::runtime_error("usage: --verify VAULT...");
+
+    auto failed = 0;
+    for (auto i = 1; i < args.size(); ++i) {
+        const std::string& file = args[i];
+        try {
+            VaultLock lock(file, VaultLock::SHARED);
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::size_t> damaged = verifyVault(file);
+            auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            auto size = fs::file_size(file);
+
+            if (damaged.empty()) {
+                std::cout << "OK    " << file << "  " << size << " bytes in " << seconds * 1000 << " ms ("
+                          << size / 1e9 / std::max(seconds, 1e-9) << " GB/s, " << checksumKernel() << ")\n";
+                continue;
+            }
+            ++failed;
+            std::cout << "FAIL  " << file << "  " << damaged.size() << " damaged block(s):";
+            for (auto j = 0; j < damaged.size() && j < 20; ++j)
+                std::cout << ' ' << damaged[j];
+            std::cout << (damaged.size() > 20 ? " ...\n" : "\n");
+        } catch (const std::exception& e) {
+            ++failed;
+            std::cout << "FAIL  " << file << "  " << e.what() << '\n';
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
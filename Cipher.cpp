@@ -0,0 +1,669 @@
+#include <string>
+#include <array>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "header.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define PM_HAVE_AVX2_KERNEL 1
+#endif
+
+namespace {
+
+constexpr std::uint32_t kdfIterations = 100000;
+constexpr std::size_t saltSize = 16;
+constexpr std::size_t nonceSize = 12;
+constexpr std::size_t tagSize = 16;
+
+auto load32(const std::uint8_t* p) -> std::uint32_t {
+    return (std::uint32_t) p[0] | ((std::uint32_t) p[1] << 8) | ((std::uint32_t) p[2] << 16) | ((std::uint32_t) p[3] << 24);
+}
+
+auto store32(std::uint8_t* p, std::uint32_t v) -> void {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+auto load64(const std::uint8_t* p) -> std::uint64_t {
+    return (std::uint64_t) load32(p) | ((std::uint64_t) load32(p + 4) << 32);
+}
+
+auto store64(std::uint8_t* p, std::uint64_t v) -> void {
+    store32(p, (std::uint32_t) v);
+    store32(p + 4, (std::uint32_t) (v >> 32));
+}
+
+auto bytes(const std::string& s) -> const std::uint8_t* {
+    return reinterpret_cast<const std::uint8_t*>(s.data());
+}
+
+// ---- SHA-256 -------------------------------------------------------------------------------------
+
+class Sha256 {
+public:
+    Sha256() { reset(); }
+
+    auto reset() -> void {
+        state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        length = 0;
+        used = 0;
+    }
+
+    auto update(const std::uint8_t* data, std::size_t size) -> void {
+        length += size;
+        while (size > 0) {
+            auto take = std::min(size, buffer.size() - used);
+            std::memcpy(buffer.data() + used, data, take);
+            used += take;
+            data += take;
+            size -= take;
+            if (used == buffer.size()) {
+                compress(buffer.data());
+                used = 0;
+            }
+        }
+    }
+
+    auto digest() -> std::string {
+        std::uint64_t bits = length * 8;
+        std::uint8_t pad = 0x80;
+        update(&pad, 1);
+        pad = 0;
+        while (used != 56)
+            update(&pad, 1);
+        std::uint8_t size[8];
+        for (auto i = 0; i < 8; ++i)
+            size[i] = bits >> (56 - 8 * i);
+        update(size, 8);
+
+        std::string out(32, '\0');
+        for (auto i = 0; i < 8; ++i)
+            for (auto j = 0; j < 4; ++j)
+                out[4 * i + j] = (char) (state[i] >> (24 - 8 * j));
+        return out;
+    }
+
+private:
+    static auto rotr(std::uint32_t x, int n) -> std::uint32_t { return (x >> n) | (x << (32 - n)); }
+
+    auto compress(const std::uint8_t* block) -> void {
+        static constexpr std::uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+        std::uint32_t w[64];
+        for (auto i = 0; i < 16; ++i)
+            w[i] = ((std::uint32_t) block[4 * i] << 24) | ((std::uint32_t) block[4 * i + 1] << 16)
+                   | ((std::uint32_t) block[4 * i + 2] << 8) | block[4 * i + 3];
+        for (auto i = 16; i < 64; ++i) {
+            auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        auto [a, b, c, d, e, f, g, h] = state;
+        for (auto i = 0; i < 64; ++i) {
+            auto t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            auto t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    std::array<std::uint32_t, 8> state{};
+    std::array<std::uint8_t, 64> buffer{};
+    std::uint64_t length = 0;
+    std::size_t used = 0;
+};
+
+// Keyed SHA-256 with the inner and outer pads absorbed once, so PBKDF2 iterations only pay for
+// the message blocks.
+class HmacSha256 {
+public:
+    explicit HmacSha256(const std::string& key) {
+        std::string k = key.size() > 64 ? sha256(key) : key;
+        k.resize(64, '\0');
+        std::string ipad(64, '\0'), opad(64, '\0');
+        for (auto i = 0; i < 64; ++i) {
+            ipad[i] = (char) (k[i] ^ 0x36);
+            opad[i] = (char) (k[i] ^ 0x5c);
+        }
+        inner.update(bytes(ipad), 64);
+        outer.update(bytes(opad), 64);
+    }
+
+    auto mac(const std::string& data) const -> std::string {
+        Sha256 in = inner;
+        in.update(bytes(data), data.size());
+        std::string innerHash = in.digest();
+        Sha256 out = outer;
+        out.update(bytes(innerHash), innerHash.size());
+        return out.digest();
+    }
+
+private:
+    Sha256 inner, outer;
+};
+
+// ---- ChaCha20 ------------------------------------------------------------------------------------
+
+auto rotl(std::uint32_t x, int n) -> std::uint32_t {
+    return (x << n) | (x >> (32 - n));
+}
+
+#define PM_QUARTER(a, b, c, d)                  \
+    a += b; d ^= a; d = rotl(d, 16);            \
+    c += d; b ^= c; b = rotl(b, 12);            \
+    a += b; d ^= a; d = rotl(d, 8);             \
+    c += d; b ^= c; b = rotl(b, 7);
+
+auto chachaBlockScalar(const std::uint32_t input[16], std::uint32_t counter, std::uint8_t out[64]) -> void {
+    std::uint32_t x[16];
+    std::memcpy(x, input, sizeof(x));
+    x[12] = counter;
+    for (auto i = 0; i < 10; ++i) {
+        PM_QUARTER(x[0], x[4], x[8], x[12])
+        PM_QUARTER(x[1], x[5], x[9], x[13])
+        PM_QUARTER(x[2], x[6], x[10], x[14])
+        PM_QUARTER(x[3], x[7], x[11], x[15])
+        PM_QUARTER(x[0], x[5], x[10], x[15])
+        PM_QUARTER(x[1], x[6], x[11], x[12])
+        PM_QUARTER(x[2], x[7], x[8], x[13])
+        PM_QUARTER(x[3], x[4], x[9], x[14])
+    }
+    for (auto i = 0; i < 16; ++i)
+        store32(out + 4 * i, x[i] + (i == 12 ? counter : input[i]));
+}
+
+#ifdef PM_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+inline auto rotlAvx2(__m256i v, int n) -> __m256i {
+    return _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - n));
+}
+
+__attribute__((target("avx2")))
+inline auto quarterAvx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d) -> void {
+    a = _mm256_add_epi32(a, b); d = rotlAvx2(_mm256_xor_si256(d, a), 16);
+    c = _mm256_add_epi32(c, d); b = rotlAvx2(_mm256_xor_si256(b, c), 12);
+    a = _mm256_add_epi32(a, b); d = rotlAvx2(_mm256_xor_si256(d, a), 8);
+    c = _mm256_add_epi32(c, d); b = rotlAvx2(_mm256_xor_si256(b, c), 7);
+}
+
+// Eight blocks at once: every register holds the same state word of eight consecutive blocks.
+__attribute__((target("avx2")))
+auto chachaBlocksAvx2(const std::uint32_t input[16], std::uint32_t counter, std::uint8_t out[512]) -> void {
+    __m256i x[16], original[16];
+    for (auto i = 0; i < 16; ++i)
+        x[i] = _mm256_set1_epi32((int) input[i]);
+    x[12] = _mm256_add_epi32(_mm256_set1_epi32((int) counter), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    for (auto i = 0; i < 16; ++i)
+        original[i] = x[i];
+
+    for (auto i = 0; i < 10; ++i) {
+        quarterAvx2(x[0], x[4], x[8], x[12]);
+        quarterAvx2(x[1], x[5], x[9], x[13]);
+        quarterAvx2(x[2], x[6], x[10], x[14]);
+        quarterAvx2(x[3], x[7], x[11], x[15]);
+        quarterAvx2(x[0], x[5], x[10], x[15]);
+        quarterAvx2(x[1], x[6], x[11], x[12]);
+        quarterAvx2(x[2], x[7], x[8], x[13]);
+        quarterAvx2(x[3], x[4], x[9], x[14]);
+    }
+
+    alignas(32) std::uint32_t words[16][8];
+    for (auto i = 0; i < 16; ++i)
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), _mm256_add_epi32(x[i], original[i]));
+    for (auto block = 0; block < 8; ++block)
+        for (auto i = 0; i < 16; ++i)
+            store32(out + 64 * block + 4 * i, words[i][block]);
+}
+
+auto haveAvx2() -> bool {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+// XORs data with the ChaCha20 keystream, keeping the position between calls.
+class ChaCha20 {
+public:
+    ChaCha20(const std::string& key, const std::string& nonce, std::uint32_t counter) : counter(counter) {
+        state[0] = 0x61707865;
+        state[1] = 0x3320646e;
+        state[2] = 0x79622d32;
+        state[3] = 0x6b206574;
+        for (auto i = 0; i < 8; ++i)
+            state[4 + i] = load32(bytes(key) + 4 * i);
+        state[12] = counter;
+        for (auto i = 0; i < 3; ++i)
+            state[13 + i] = load32(bytes(nonce) + 4 * i);
+    }
+
+    auto apply(std::uint8_t* data, std::size_t size) -> void {
+        while (size > 0) {
+            if (offset == filled)
+                refill(size);
+            auto take = std::min(size, filled - offset);
+            const std::uint8_t* stream = keystream.data() + offset;
+            for (std::size_t i = 0; i < take; ++i)
+                data[i] ^= stream[i];
+            offset += take;
+            data += take;
+            size -= take;
+        }
+    }
+
+private:
+    auto refill(std::size_t wanted) -> void {
+        offset = 0;
+#ifdef PM_HAVE_AVX2_KERNEL
+        if (wanted > 64 && haveAvx2()) {
+            chachaBlocksAvx2(state.data(), counter, keystream.data());
+            counter += 8;
+            filled = keystream.size();
+            return;
+        }
+#endif
+        auto blocks = std::min<std::size_t>(8, (wanted + 63) / 64);
+        for (std::size_t block = 0; block < blocks; ++block)
+            chachaBlockScalar(state.data(), counter++, keystream.data() + 64 * block);
+        filled = 64 * blocks;
+    }
+
+    std::array<std::uint32_t, 16> state{};
+    std::array<std::uint8_t, 512> keystream{};
+    std::size_t offset = 0;
+    std::size_t filled = 0;
+    std::uint32_t counter;
+};
+
+// ---- Poly1305 ------------------------------------------------------------------------------------
+
+class Poly1305 {
+public:
+    explicit Poly1305(const std::uint8_t key[32]) {
+        auto t0 = load64(key), t1 = load64(key + 8);
+        r0 = t0 & 0xffc0fffffff;
+        r1 = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+        r2 = (t1 >> 24) & 0x00ffffffc0f;
+        pad0 = load64(key + 16);
+        pad1 = load64(key + 24);
+    }
+
+    auto update(const std::uint8_t* data, std::size_t size) -> void {
+        if (used > 0) {
+            auto take = std::min(size, 16 - used);
+            std::memcpy(buffer + used, data, take);
+            used += take;
+            data += take;
+            size -= take;
+            if (used < 16)
+                return;
+            blocks(buffer, 16);
+            used = 0;
+        }
+        auto whole = size & ~std::size_t(15);
+        blocks(data, whole);
+        std::memcpy(buffer, data + whole, size - whole);
+        used = size - whole;
+    }
+
+    // Zero pads the pending bytes to a whole block, as the AEAD construction requires.
+    auto padToBlock() -> void {
+        if (used > 0) {
+            std::memset(buffer + used, 0, 16 - used);
+            blocks(buffer, 16);
+            used = 0;
+        }
+    }
+
+    auto finish(std::uint8_t tag[16]) -> void {
+        padToBlock();
+        constexpr std::uint64_t m44 = 0xfffffffffff, m42 = 0x3ffffffffff;
+        std::uint64_t c;
+        c = h1 >> 44; h1 &= m44; h2 += c;
+        c = h2 >> 42; h2 &= m42; h0 += c * 5;
+        c = h0 >> 44; h0 &= m44; h1 += c;
+        c = h1 >> 44; h1 &= m44; h2 += c;
+        c = h2 >> 42; h2 &= m42; h0 += c * 5;
+        c = h0 >> 44; h0 &= m44; h1 += c;
+
+        auto g0 = h0 + 5;
+        c = g0 >> 44; g0 &= m44;
+        auto g1 = h1 + c;
+        c = g1 >> 44; g1 &= m44;
+        auto g2 = h2 + c - ((std::uint64_t) 1 << 42);
+
+        c = (g2 >> 63) - 1;
+        g0 &= c; g1 &= c; g2 &= c;
+        c = ~c;
+        h0 = (h0 & c) | g0;
+        h1 = (h1 & c) | g1;
+        h2 = (h2 & c) | g2;
+
+        h0 += pad0 & m44;
+        c = h0 >> 44; h0 &= m44;
+        h1 += (((pad0 >> 44) | (pad1 << 20)) & m44) + c;
+        c = h1 >> 44; h1 &= m44;
+        h2 += ((pad1 >> 24) & m42) + c;
+        h2 &= m42;
+
+        store64(tag, h0 | (h1 << 44));
+        store64(tag + 8, (h1 >> 20) | (h2 << 24));
+    }
+
+private:
+    auto blocks(const std::uint8_t* data, std::size_t size) -> void {
+        using u128 = unsigned __int128;
+        constexpr std::uint64_t m44 = 0xfffffffffff, m42 = 0x3ffffffffff;
+        const std::uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+
+        for (; size >= 16; data += 16, size -= 16) {
+            auto t0 = load64(data), t1 = load64(data + 8);
+            h0 += t0 & m44;
+            h1 += ((t0 >> 44) | (t1 << 20)) & m44;
+            h2 += ((t1 >> 24) & m42) | ((std::uint64_t) 1 << 40);
+
+            u128 d0 = (u128) h0 * r0 + (u128) h1 * s2 + (u128) h2 * s1;
+            u128 d1 = (u128) h0 * r1 + (u128) h1 * r0 + (u128) h2 * s2;
+            u128 d2 = (u128) h0 * r2 + (u128) h1 * r1 + (u128) h2 * r0;
+
+            std::uint64_t c = (std::uint64_t) (d0 >> 44);
+            h0 = (std::uint64_t) d0 & m44;
+            d1 += c;
+            c = (std::uint64_t) (d1 >> 44);
+            h1 = (std::uint64_t) d1 & m44;
+            d2 += c;
+            c = (std::uint64_t) (d2 >> 42);
+            h2 = (std::uint64_t) d2 & m42;
+            h0 += c * 5;
+            c = h0 >> 44;
+            h0 &= m44;
+            h1 += c;
+        }
+    }
+
+    std::uint64_t r0, r1, r2, pad0, pad1;
+    std::uint64_t h0 = 0, h1 = 0, h2 = 0;
+    std::uint8_t buffer[16]{};
+    std::size_t used = 0;
+};
+
+// ---- Engines -------------------------------------------------------------------------------------
+
+class XorEngine : public CipherEngine {
+public:
+    explicit XorEngine(std::string password) : password(std::move(password)) {}
+
+    auto name() const -> std::string override { return "xor"; }
+    auto tagSize() const -> std::size_t override { return 0; }
+
+    auto encrypt(std::string& data) -> void override { decrypt(data); }
+
+    auto decrypt(std::string& data) -> void override {
+        for (char& c : data) {
+            c = (char) (c ^ password[position]);
+            if (++position >= password.length())
+                position = 0;
+        }
+    }
+
+    auto tag() -> std::string override { return ""; }
+    auto finish(const std::string&) -> void override {}
+    auto recordKey() const -> std::string override { return ""; }
+
+private:
+    std::string password;
+    std::size_t position = 0;
+};
+
+// RFC 8439 ChaCha20-Poly1305. The vault header line is the associated data, so the KDF parameters
+// are authenticated together with the body.
+class ChaChaPolyEngine : public CipherEngine {
+public:
+    ChaChaPolyEngine(const std::string& key, const std::string& nonce, const std::string& aad)
+        : key(key), stream(key, nonce, 1), mac(polyKey(key, nonce).data()), aadSize(aad.size()) {
+        mac.update(bytes(aad), aad.size());
+        mac.padToBlock();
+    }
+
+    auto name() const -> std::string override { return "chacha20-poly1305"; }
+    auto tagSize() const -> std::size_t override { return ::tagSize; }
+
+    auto encrypt(std::string& data) -> void override {
+        encrypt(data.data(), data.size());
+    }
+
+    auto decrypt(std::string& data) -> void override {
+        decrypt(data.data(), data.size());
+    }
+
+    auto encrypt(char* data, std::size_t size) -> void {
+        auto p = reinterpret_cast<std::uint8_t*>(data);
+        stream.apply(p, size);
+        mac.update(p, size);
+        dataSize += size;
+    }
+
+    auto decrypt(char* data, std::size_t size) -> void {
+        auto p = reinterpret_cast<std::uint8_t*>(data);
+        mac.update(p, size);
+        stream.apply(p, size);
+        dataSize += size;
+    }
+
+    auto tag() -> std::string override {
+        mac.padToBlock();
+        std::uint8_t lengths[16];
+        store64(lengths, aadSize);
+        store64(lengths + 8, dataSize);
+        mac.update(lengths, 16);
+        std::string out(::tagSize, '\0');
+        mac.finish(reinterpret_cast<std::uint8_t*>(out.data()));
+        return out;
+    }
+
+    auto finish(const std::string& expected) -> void override {
+        std::string actual = tag();
+        std::uint8_t difference = expected.size() != actual.size();
+        for (auto i = 0; i < actual.size() && i < expected.size(); ++i)
+            difference |= actual[i] ^ expected[i];
+        if (difference != 0)
+            throw std::runtime_error("wrong password or corrupted vault");
+    }
+
+    auto recordKey() const -> std::string override {
+        return hmacSha256(key, "record secrets");
+    }
+
+private:
+    static auto polyKey(const std::string& key, const std::string& nonce) -> std::array<std::uint8_t, 64> {
+        std::array<std::uint8_t, 64> block{};
+        ChaCha20(key, nonce, 0).apply(block.data(), block.size());
+        return block;
+    }
+
+    std::string key;
+    ChaCha20 stream;
+    Poly1305 mac;
+    std::uint64_t aadSize;
+    std::uint64_t dataSize = 0;
+};
+
+auto parseHeader(const std::string& header) -> std::map<std::string, std::string> {
+    std::map<std::string, std::string> fields;
+    std::istringstream iss(header.substr(vaultHeaderTag.size()));
+    std::string field;
+    while (iss >> field) {
+        auto equals = field.find('=');
+        if (equals != std::string::npos)
+            fields[field.substr(0, equals)] = field.substr(equals + 1);
+    }
+    return fields;
+}
+
+}
+
+auto sha256(const std::string& data) -> std::string {
+    Sha256 hash;
+    hash.update(bytes(data), data.size());
+    return hash.digest();
+}
+
+auto hmacSha256(const std::string& key, const std::string& data) -> std::string {
+    return HmacSha256(key).mac(data);
+}
+
+auto pbkdf2Sha256(const std::string& password, const std::string& salt, std::uint32_t iterations) -> std::string {
+    HmacSha256 prf(password);
+    std::string block = salt + std::string("\0\0\0\1", 4);
+    std::string u = prf.mac(block);
+    std::string result = u;
+    for (std::uint32_t i = 1; i < iterations; ++i) {
+        u = prf.mac(u);
+        for (auto j = 0; j < result.size(); ++j)
+            result[j] ^= u[j];
+    }
+    return result;
+}
+
+auto randomBytes(std::size_t count) -> std::string {
+    std::random_device device;
+    std::string out(count, '\0');
+    for (auto& c : out)
+        c = (char) device();
+    return out;
+}
+
+auto toHex(const std::string& data) -> std::string {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string out(data.size() * 2, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        auto byte = (std::uint8_t) data[i];
+        out[2 * i] = digits[byte >> 4];
+        out[2 * i + 1] = digits[byte & 15];
+    }
+    return out;
+}
+
+auto fromHex(const std::string& text) -> std::string {
+    static const auto table = [] {
+        std::array<std::int8_t, 256> t{};
+        t.fill(-1);
+        for (auto c = 0; c < 10; ++c)
+            t['0' + c] = (std::int8_t) c;
+        for (auto c = 0; c < 6; ++c) {
+            t['a' + c] = (std::int8_t) (10 + c);
+            t['A' + c] = (std::int8_t) (10 + c);
+        }
+        return t;
+    }();
+
+    std::string out;
+    out.reserve(text.size() / 2);
+    auto pending = -1;
+    for (char c : text) {
+        auto value = table[(std::uint8_t) c];
+        if (value < 0)
+            continue;
+        if (pending < 0) {
+            pending = value;
+        } else {
+            out += (char) ((pending << 4) | value);
+            pending = -1;
+        }
+    }
+    return out;
+}
+
+auto cipherKernel() -> std::string {
+#ifdef PM_HAVE_AVX2_KERNEL
+    if (haveAvx2())
+        return "avx2";
+#endif
+    return "scalar";
+}
+
+auto makeCipherEngine(const std::string& header, const std::string& password) -> std::unique_ptr<CipherEngine> {
+    if (header.empty())
+        return std::make_unique<XorEngine>(password);
+
+    auto fields = parseHeader(header);
+    if (fields["cipher"] != "chacha20-poly1305" || fields["kdf"] != "pbkdf2-sha256")
+        throw std::runtime_error("unsupported cipher '" + fields["cipher"] + "'");
+
+    std::string salt = fromHex(fields["salt"]);
+    std::string nonce = fromHex(fields["nonce"]);
+    auto iterations = std::stoul(fields["iter"]);
+    if (salt.size() != saltSize || nonce.size() != nonceSize || iterations == 0)
+        throw std::runtime_error("corrupted vault header");
+
+    return std::make_unique<ChaChaPolyEngine>(pbkdf2Sha256(password, salt, iterations), nonce, header);
+}
+
+namespace {
+
+auto sealWithNonce(const std::string& recordKey, const std::string& nonce, std::string_view plain) -> std::string {
+    ChaChaPolyEngine engine(recordKey, nonce, "");
+    std::string sealed = nonce;
+    sealed.append(plain);
+    engine.encrypt(sealed.data() + nonceSize, plain.size());
+    return sealed + engine.tag();
+}
+
+}
+
+auto sealSecret(const std::string& recordKey, std::uint64_t counter, std::string_view plain) -> std::string {
+    std::string nonce(nonceSize, '\0');
+    store64(reinterpret_cast<std::uint8_t*>(nonce.data()) + 4, counter);
+    return sealWithNonce(recordKey, nonce, plain);
+}
+
+auto sealSecret(const std::string& recordKey, std::string_view plain) -> std::string {
+    return sealWithNonce(recordKey, randomBytes(nonceSize), plain);
+}
+
+auto openSecret(const std::string& recordKey, std::string_view blob) -> SecureString {
+    if (blob.size() < nonceSize + tagSize)
+        throw std::runtime_error("corrupted secret");
+
+    ChaChaPolyEngine engine(recordKey, std::string(blob.substr(0, nonceSize)), "");
+    SecureString plain(blob.substr(nonceSize, blob.size() - nonceSize - tagSize));
+    engine.decrypt(plain.data(), plain.size());
+    engine.finish(std::string(blob.substr(blob.size() - tagSize)));
+    return plain;
+}
+
+auto newVaultHeader(std::uint64_t generation) -> std::string {
+    return vaultHeaderTag + "cipher=chacha20-poly1305 kdf=pbkdf2-sha256 iter=" + std::to_string(kdfIterations)
+           + " salt=" + toHex(randomBytes(saltSize)) + " nonce=" + toHex(randomBytes(nonceSize))
+           + (generation > 0 ? " gen=" + std::to_string(generation) : "");
+}
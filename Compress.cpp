@@ -0,0 +1,173 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "header.hpp"
+
+// Block codec using the LZ4 block format: sequences of literals followed by a match (offset, length),
+// with a greedy single-probe hash table as match finder.
+
+namespace {
+
+const std::string magic = "\x1bPMZ";
+
+constexpr int minMatch = 4;
+constexpr int hashBits = 16;
+constexpr std::size_t lastLiterals = 5;
+constexpr std::size_t matchSafeDistance = 12;
+constexpr std::size_t maxOffset = 65535;
+
+auto read32(const char* p) -> std::uint32_t {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+auto hash(std::uint32_t sequence) -> std::uint32_t {
+    return (sequence * 2654435761u) >> (32 - hashBits);
+}
+
+auto writeLength(std::string& out, std::size_t length) -> void {
+    while (length >= 255) {
+        out += (char) 255;
+        length -= 255;
+    }
+    out += (char) length;
+}
+
+auto writeSequence(std::string& out, const char* literals, std::size_t literalLength,
+                   std::size_t offset, std::size_t matchLength) -> void {
+    auto token = (std::uint8_t) ((literalLength < 15 ? literalLength : 15) << 4);
+    if (matchLength > 0) {
+        auto extra = matchLength - minMatch;
+        token |= extra < 15 ? extra : 15;
+    }
+    out += (char) token;
+    if (literalLength >= 15)
+        writeLength(out, literalLength - 15);
+    out.append(literals, literalLength);
+
+    if (matchLength > 0) {
+        out += (char) (offset & 0xff);
+        out += (char) (offset >> 8);
+        if (matchLength - minMatch >= 15)
+            writeLength(out, matchLength - minMatch - 15);
+    }
+}
+
+auto readLength(const std::string& in, std::size_t& pos) -> std::size_t {
+    std::size_t length = 0;
+    std::uint8_t byte;
+    do {
+        if (pos >= in.size())
+            throw std::runtime_error("corrupted compressed data");
+        byte = in[pos++];
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+}
+
+auto isCompressed(std::string_view text) -> bool {
+    return text.size() >= magic.size() + 8 && text.starts_with(magic);
+}
+
+auto compressText(const std::string& text) -> std::string {
+    std::string out = magic;
+    for (auto i = 0; i < 8; ++i)
+        out += (char) ((std::uint64_t) text.size() >> (8 * i));
+    out.reserve(out.size() + text.size() / 2);
+
+    const char* base = text.data();
+    std::size_t size = text.size();
+    std::size_t anchor = 0;
+    std::vector<std::uint32_t> table(1 << hashBits, 0);
+
+    if (size > matchSafeDistance) {
+        std::size_t limit = size - matchSafeDistance;
+        std::size_t pos = 1;
+        while (pos < limit) {
+            auto sequence = read32(base + pos);
+            auto& slot = table[hash(sequence)];
+            std::size_t candidate = slot;
+            slot = (std::uint32_t) pos;
+
+            if (candidate == 0 || pos - candidate > maxOffset || read32(base + candidate) != sequence) {
+                ++pos;
+                continue;
+            }
+
+            while (pos > anchor && candidate > 0 && base[pos - 1] == base[candidate - 1]) {
+                --pos;
+                --candidate;
+            }
+
+            std::size_t length = minMatch;
+            std::size_t matchLimit = size - lastLiterals;
+            while (pos + length < matchLimit && base[candidate + length] == base[pos + length])
+                ++length;
+
+            writeSequence(out, base + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+            if (pos - 2 > 0 && pos - 2 < limit)
+                table[hash(read32(base + pos - 2))] = (std::uint32_t) (pos - 2);
+        }
+    }
+    writeSequence(out, base + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+auto decompressText(const std::string& data) -> std::string {
+    if (!isCompressed(data))
+        throw std::runtime_error("not compressed data");
+
+    std::uint64_t size = 0;
+    for (auto i = 0; i < 8; ++i)
+        size |= (std::uint64_t) (std::uint8_t) data[magic.size() + i] << (8 * i);
+
+    if (size / 255 > data.size())
+        throw std::runtime_error("corrupted compressed data");
+
+    std::string out;
+    out.reserve(size);
+    std::size_t pos = magic.size() + 8;
+
+    while (pos < data.size()) {
+        std::uint8_t token = data[pos++];
+        std::size_t literalLength = token >> 4;
+        if (literalLength == 15)
+            literalLength += readLength(data, pos);
+        if (pos + literalLength > data.size() || out.size() + literalLength > size)
+            throw std::runtime_error("corrupted compressed data");
+        out.append(data, pos, literalLength);
+        pos += literalLength;
+
+        if (pos >= data.size())
+            break;
+        if (pos + 2 > data.size())
+            throw std::runtime_error("corrupted compressed data");
+        std::size_t offset = (std::uint8_t) data[pos] | ((std::uint8_t) data[pos + 1] << 8);
+        pos += 2;
+        std::size_t matchLength = token & 15;
+        if (matchLength == 15)
+            matchLength += readLength(data, pos);
+        matchLength += minMatch;
+
+        if (offset == 0 || offset > out.size() || out.size() + matchLength > size)
+            throw std::runtime_error("corrupted compressed data");
+        std::size_t from = out.size() - offset;
+        if (offset >= matchLength) {
+            out.append(out, from, matchLength);
+        } else {
+            for (std::size_t i = 0; i < matchLength; ++i)
+                out += out[from + i];
+        }
+    }
+
+    if (out.size() != size)
+        throw std::runtime_error("corrupted compressed data");
+    return out;
+}
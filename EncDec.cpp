@@ -1,54 +1,65 @@
 #include <iostream>
 #include <filesystem>
 #include <string>
+#include <string_view>
+#include <algorithm>
 #include "header.hpp"
 
-auto encryptText(const std::string& text) -> std::string {
+auto readPassword() -> std::string {
     std::string password;
     std::cout << "Enter the file password: ";
     std::cin >> password;
-
-    std::string encrypted;
-    auto passwordItr = 0;
-    std::stringstream s;
-
-    for (char i : text) {
-        auto temp = i ^ password[passwordItr];
-        s << std::hex << std::setfill('0') << std::setw(2) << (int)(temp);
-        passwordItr++;
-        if (passwordItr >= password.length()) {
-            passwordItr = 0;
-        }
-    }
-    s >> encrypted;
-    return encrypted;
+    return password;
 }
 
-auto decryptText(const std::string& text) -> std::string {
+auto encryptText(const std::string& text, const std::string& header, CipherEngine& engine,
+                 const std::string& secrets) -> std::string {
+    std::string encrypted = text;
+    engine.encrypt(encrypted);
+    encrypted += engine.tag();
 
-    std::string password;
-
-    std::cout << "Enter the file password: ";
-    std::cin >> password;
+    std::string body = toHex(encrypted);
+    return header + '\n' + makeBlockTable(body) + '\n' + (secrets.empty() ? "" : secrets + '\n') + body;
+}
 
-    std::string hexToUni;
+auto decryptText(const std::string& text, const std::string& password, RecordKey* recordKey,
+                 SealedSecrets* secrets) -> std::string {
+    std::string header;
+    std::string body = text;
 
-    for (auto i = 0; i < text.length() - 1; i += 2) {
-        std::string output = text.substr(i, 2);
-        long decimal = std::strtol(output.c_str(), nullptr, 16);
-        hexToUni += (char) (decimal);
+    if (text.starts_with(vaultHeaderTag)) {
+        auto newline = text.find('\n');
+        header = text.substr(0, newline);
+        body = newline == std::string::npos ? "" : text.substr(newline + 1);
     }
-
-    std::string decrypted;
-    int passwordItr = 0;
-    for (char i: hexToUni) {
-        auto temp = i ^ password[passwordItr];
-        decrypted += (char) (temp);
-        passwordItr++;
-        if (passwordItr >= password.length()) {
-            passwordItr = 0;
+    if (isBlockTable(body)) {
+        auto newline = body.find('\n');
+        BlockVerifier verifier(parseBlockTable(body.substr(0, newline)));
+        body = newline == std::string::npos ? "" : body.substr(newline + 1);
+        if (isSecretsSection(body)) {
+            newline = body.find('\n');
+            if (secrets)
+                *secrets = parseSecretsSection(std::string_view(body).substr(0, newline));
+            body = newline == std::string::npos ? "" : body.substr(newline + 1);
         }
+        std::string_view checked = body;
+        verifier.update(checked.substr(0, std::min(checked.find('\n'), checked.size())));
+        verifier.finish();
     }
 
+    auto engine = makeCipherEngine(header, password);
+    std::string decrypted = fromHex(body);
+    if (decrypted.size() < engine->tagSize())
+        throw std::runtime_error("wrong password or corrupted vault");
+
+    std::string tag = decrypted.substr(decrypted.size() - engine->tagSize());
+    decrypted.resize(decrypted.size() - engine->tagSize());
+    engine->decrypt(decrypted);
+    engine->finish(tag);
+
+    if (recordKey) {
+        std::string key = engine->recordKey();
+        *recordKey = key.empty() ? nullptr : std::make_shared<const std::string>(std::move(key));
+    }
     return decrypted;
 }
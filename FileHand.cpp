@@ -4,50 +4,123 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <chrono>
+#include <iomanip>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
 #include "header.hpp"
 
 namespace fs = std::filesystem;
 
-auto selectFile() -> std::string {
-
-    std::string folderPath = "/Users/bskrobich/CLionProjects/ProjektPJC/";
-
-    std::cout << ">>> Select an available path [NUMBER] or press [0] for entering an absolute path:\n";
-
-    auto i = int();
+auto discoverVaults(const std::string& folderPath) -> std::vector<std::string> {
+    std::vector<std::string> vaults;
 
     for (const auto &entry: fs::directory_iterator(folderPath)) {
         if (entry.path().filename() != "CMakeLists.txt") {
             if (entry.is_regular_file() && entry.path().extension() == ".txt") {
-                ++i;
-                std::cout << i << ". " << entry.path() << std::endl;
+                vaults.push_back(entry.path().string());
             }
         }
     }
+    return vaults;
+}
+
+auto settings() -> Settings& {
+    static Settings current;
+    return current;
+}
+
+auto defaultVaultFolder() -> std::string {
+    if (!settings().vaultFolder.empty())
+        return settings().vaultFolder;
+    if (const char* folder = std::getenv("PM_VAULT_DIR"); folder && *folder)
+        return folder;
+    return ".";
+}
+
+auto recentVaultsPath() -> std::string {
+    if (const char* cache = std::getenv("XDG_CACHE_HOME"); cache && *cache)
+        return std::string(cache) + "/projektpjc-recent";
+    if (const char* home = std::getenv("HOME"); home && *home)
+        return std::string(home) + "/.cache/projektpjc-recent";
+    return "";
+}
+
+auto recentVaults() -> std::vector<std::string> {
+    std::vector<std::string> vaults;
+    std::ifstream input(recentVaultsPath());
+    std::string line;
+
+    while (std::getline(input, line)) {
+        if (!line.empty() && fs::is_regular_file(line))
+            vaults.push_back(line);
+    }
+    return vaults;
+}
+
+auto rememberVault(const std::string& file) -> void {
+    std::string path = recentVaultsPath();
+    if (path.empty())
+        return;
+
+    std::error_code error;
+    std::string absolute = fs::absolute(file, error).lexically_normal().string();
+    std::vector<std::string> vaults = {absolute};
+    for (const std::string& vault : recentVaults()) {
+        if (vault != absolute && vaults.size() < recentVaultLimit)
+            vaults.push_back(vault);
+    }
+
+    fs::create_directories(fs::path(path).parent_path(), error);
+    std::ofstream output(path + ".tmp");
+    for (const std::string& vault : vaults)
+        output << vault << '\n';
+    output.close();
+    fs::rename(path + ".tmp", path, error);
+}
+
+auto selectFile() -> std::string {
+
+    std::string folderPath = defaultVaultFolder();
+    std::vector<std::string> vaults = recentVaults();
+    auto recent = !vaults.empty();
+    if (!recent)
+        vaults = discoverVaults(folderPath);
+
+    auto printVaults = [&]() {
+        std::cout << ">>> Select an available path [NUMBER] or press [0] for entering an absolute path"
+                  << (recent ? ", [S] to scan " + folderPath : "") << ":\n";
+        for (auto i = 0; i < vaults.size(); ++i) {
+            std::cout << i + 1 << ". " << fs::path(vaults[i]) << std::endl;
+        }
+    };
+    printVaults();
 
     auto selectedFile = fs::path();
 
     while (selectedFile.empty()) {
         std::string input;
-        auto num = int();
         auto choice = int();
 
         std::cout << "Your choice: ";
         std::cin >> input;
+        if (recent && (input == "s" || input == "S")) {
+            recent = false;
+            vaults = discoverVaults(folderPath);
+            printVaults();
+            continue;
+        }
         try {
             choice = std::stoi(input);
-            if (choice > 0 && choice <= i) {
-                for (const auto &entry: fs::directory_iterator(folderPath)) {
-                    if (entry.path().filename() != "CMakeLists.txt") {
-                        if (entry.is_regular_file() && entry.path().extension() == ".txt") {
-                            ++num;
-                            if (num == choice) {
-                                selectedFile = entry.path();
-                                break;
-                            }
-                        }
-                    }
-                }
+            if (choice > 0 && choice <= vaults.size()) {
+                selectedFile = vaults[choice - 1];
             } else if (choice == 0) {
                 std::cout << "Enter absolute path: ";
                 std::cin >> selectedFile;
@@ -67,95 +140,256 @@ auto selectFile() -> std::string {
     return selectedFile;
 }
 
-auto splitString(const std::string &input) -> std::vector<PasswordData> {
-
-    std::vector<PasswordData> result;
+auto parseLine(std::string_view line, const RecordKey& key, const SealedSecrets* secrets) -> PasswordData {
     PasswordData passwordData;
 
-    std::istringstream iss(input);
-    std::string line;
+    // Whitespace separated fields, read without a stream so parsing threads share no locale state.
+    auto nextField = [&line]() {
+        auto start = std::min(line.find_first_not_of(" \t\r\v\f"), line.size());
+        auto end = std::min(line.find_first_of(" \t\r\v\f", start), line.size());
+        std::string_view field = line.substr(start, end - start);
+        line.remove_prefix(end);
+        return field;
+    };
+    std::string_view name = nextField(), password = nextField(), category = nextField();
 
-    while(std::getline(iss, line)) {
-        std::istringstream lineStream(line);
+    passwordData.name = name;
+    passwordData.password = Secret::fromToken(std::string(password), key, secrets);
+    passwordData.category = category;
 
-        std::string name, password, category, website, login;
-        lineStream >> name >> password >> category;
+    std::string_view website = nextField(), login = nextField();
+    if (!login.empty()) {
+        passwordData.website = website;
+        passwordData.login = login;
+    }
+    return passwordData;
+}
 
-        passwordData.name = name;
-        passwordData.password = password;
-        passwordData.category = category;
+auto parseRecords(std::string_view text, const RecordKey& key, std::size_t threadCount,
+                  const SealedSecrets* secrets) -> std::vector<PasswordData> {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::max<std::size_t>(1, std::min(threadCount, text.size() / minimumParseChunk));
 
-        if (lineStream >> website >> login) {
-            passwordData.website = website;
-            passwordData.login = login;
-        } else {
-            passwordData.website = std::nullopt;
-            passwordData.login = std::nullopt;
+    // Chunks end after a newline, so no line is split between two threads.
+    std::vector<std::string_view> chunks;
+    while (!text.empty()) {
+        auto end = text.size();
+        if (chunks.size() + 1 < threadCount) {
+            auto newline = text.find('\n', std::min(text.size(), text.size() / (threadCount - chunks.size())));
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
         }
-        result.push_back(passwordData);
+        chunks.push_back(text.substr(0, end));
+        text.remove_prefix(end);
     }
+
+    // Every thread fills its own block; the blocks are joined in file order afterwards.
+    std::vector<std::vector<PasswordData>> blocks(chunks.size());
+    auto parse = [&](std::size_t i) {
+        SecretArena::Lease lease(secretArena());
+        for (std::string_view rest = chunks[i]; !rest.empty();) {
+            auto newline = std::min(rest.find('\n'), rest.size());
+            blocks[i].push_back(parseLine(rest.substr(0, newline), key, secrets));
+            rest.remove_prefix(std::min(newline + 1, rest.size()));
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < chunks.size(); ++i)
+        threads.emplace_back(parse, i);
+    if (!chunks.empty())
+        parse(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    if (blocks.size() == 1)
+        return std::move(blocks.front());
+    std::vector<PasswordData> result;
+    result.reserve(std::accumulate(blocks.begin(), blocks.end(), std::size_t(0),
+                                   [](std::size_t sum, const auto& block) { return sum + block.size(); }));
+    for (auto& block : blocks)
+        result.insert(result.end(), std::make_move_iterator(block.begin()), std::make_move_iterator(block.end()));
     return result;
 }
 
+auto splitString(const std::string &input, const RecordKey& key, const SealedSecrets* secrets)
+    -> std::vector<PasswordData> {
+
+    if (isCompressed(input))
+        return splitString(decompressText(input), key, secrets);
+
+    return parseRecords(input, key, 0, secrets);
+}
+
 auto fileModify(const std::string& file, const std::string& data) -> void {
-    std::ofstream output(file);
-    output << data;
-    output.close();
+    // The new content is written next to the file and renamed over it, so a reader sees either the old
+    // or the new version, never a truncated one.
+    std::string temporary = file + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+        throw std::runtime_error("cannot write " + temporary);
+
+    std::size_t written = 0;
+    while (written < data.size()) {
+        auto count = write(fd, data.data() + written, data.size() - written);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0) {
+            close(fd);
+            fs::remove(temporary);
+            throw std::runtime_error("cannot write " + temporary);
+        }
+        written += count;
+    }
+    auto synced = fsync(fd) == 0;
+    close(fd);
+    if (!synced) {
+        fs::remove(temporary);
+        throw std::runtime_error("cannot write " + temporary);
+    }
+
+    if (fs::exists(file))
+        fs::permissions(temporary, fs::status(file).permissions());
+    fs::rename(temporary, file);
+}
+
+auto moveAside(const std::string& path) -> std::string {
+    for (std::uint64_t number = 1;; ++number) {
+        std::string old = path + ".old." + std::to_string(number);
+        if (!fs::exists(fs::symlink_status(old))) {
+            fs::rename(path, old);
+            return old;
+        }
+    }
+}
+
+auto setAside(const std::string& path, const std::string& what, const std::string& reason) -> std::string {
+    // What cannot be opened was saved with another password or is damaged. It is kept under a new name,
+    // so nothing is lost when the caller starts over.
+    std::string old = moveAside(path);
+    std::cout << ">>> " << what << " could not be opened (" << reason << "), moved to " << old << ".\n";
+    return old;
 }
 
-auto makeTimestamp(const std::string& file) -> void {
-    std::ifstream input(file);
+auto replacePath(const std::string& staged, const std::string& path) -> void {
+    if (staged.empty())
+        return;
+    // Both paths trade places in one step, so a reader never finds the path missing; the old
+    // content is removed afterwards.
+    if (renameat2(AT_FDCWD, staged.c_str(), AT_FDCWD, path.c_str(), RENAME_EXCHANGE) != 0)
+        throw std::runtime_error("cannot replace " + path + " with " + staged + ": " + std::strerror(errno));
+    fs::remove_all(staged);
+}
+
+auto currentTimestamp() -> std::string {
+    std::time_t currentTime = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&currentTime), "%Y-%m-%d %H:%M:%S");
+    return ss.str();
+}
 
+auto readVaultBody(const std::string& file) -> std::string {
+    std::ifstream stream(file);
     std::string data;
     std::string line;
-    auto found = false;
-
-    while(std::getline(input, line)) {
-        if (line.substr(0, 12) == "[TIMESTAMP] ") {
-            std::chrono::system_clock::time_point currentTime = std::chrono::system_clock::now();
-            std::time_t currentTime_t = std::chrono::system_clock::to_time_t(currentTime);
-
-            std::stringstream ss;
-            ss << std::put_time(std::localtime(&currentTime_t), "%Y-%m-%d %H:%M:%S");
-            std::string timestamp = ss.str();
-            data += "[TIMESTAMP] " + timestamp;
-            found = true;
-        } else
+
+    while(std::getline(stream, line)){
+        if (line.substr(0, 12) != "[TIMESTAMP] ")
             data += line + '\n';
-    } input.close();
+    }
+    return data;
+}
 
-    if (!found) {
-        std::chrono::system_clock::time_point currentTime = std::chrono::system_clock::now();
-        std::time_t currentTime_t = std::chrono::system_clock::to_time_t(currentTime);
+auto loadVault(const std::string& file, const std::string& password, VaultInfo* info) -> std::vector<PasswordData> {
+    VaultLock lock(file, VaultLock::SHARED);
+    if (isFileEmpty(file))
+        return {};
 
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&currentTime_t), "%Y-%m-%d %H:%M:%S");
-        std::string timestamp = ss.str();
-        data += "[TIMESTAMP] " + timestamp;
+    RecordKey key;
+    SealedSecrets secrets;
+    std::string body = readVaultBody(file);
+    std::string decrypted = decryptText(body, password, &key, &secrets);
+    if (info) {
+        info->generation = headerGeneration(std::string_view(body).substr(0, body.find('\n')));
+        info->compressed = isCompressed(decrypted);
     }
-    fileModify(file, data);
+    return splitString(decrypted, key, &secrets);
 }
 
-auto fileRead() -> void {
-    std::vector<PasswordData> passwords;
-    std::string file = selectFile();
+auto startupBenchmark(const std::string& file) -> void {
+    std::string password = readPassword();
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
 
-    if (!isFileEmpty(file)) {
-        std::ifstream stream(file);
-        std::string data;
-        std::string line;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> recent = recentVaults();
+    auto cached = std::chrono::steady_clock::now();
+    std::vector<std::string> scanned = discoverVaults(defaultVaultFolder());
+    auto scanDone = std::chrono::steady_clock::now();
+    std::cout << ">>> Selection: recent cache " << ms(start, cached) << " ms (" << recent.size() << " vault(s)), folder scan "
+              << ms(cached, scanDone) << " ms (" << scanned.size() << " vault(s)).\n";
 
-        while(std::getline(stream, line)){
-            if (line.substr(0, 12) != "[TIMESTAMP] ")
-                data += line + '\n';
+    for (const std::string run : {"Cold", "Warm"}) {
+        if (run == "Cold") {
+            // Drop the cached pages of the vault, so the first open has to read it from disk.
+            int fd = open(file.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                fdatasync(fd);
+                posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                close(fd);
+            }
         }
-        stream.close();
 
-        std::string decrypted = decryptText(data);
-        passwords = splitString(decrypted);
+        auto opening = std::chrono::steady_clock::now();
+        std::ifstream stream(file, std::ios::binary);
+        // The callback sees records before the vault is authenticated, so it only takes the time.
+        std::optional<std::chrono::steady_clock::time_point> firstRecord;
+        std::vector<PasswordData> passwords = readPipeline(stream, password, [&](const PasswordData&) {
+            if (!firstRecord)
+                firstRecord = std::chrono::steady_clock::now();
+        });
+        std::cout << ">>> " << run << " open: " << ms(opening, std::chrono::steady_clock::now()) << " ms ("
+                  << passwords.size() << " password(s), first after "
+                  << (firstRecord ? ms(opening, *firstRecord) : 0.0) << " ms).\n";
+        passwords.clear();
+        secretArena().wipe();
+    }
+}
+
+auto fileRead() -> void {
+    std::vector<PasswordData> passwords;
+    auto started = std::chrono::steady_clock::now();
+    std::string file = settings().vaultPath.empty() ? selectFile() : settings().vaultPath;
+    auto selected = std::chrono::steady_clock::now();
 
-        makeTimestamp(file);
+    if (!fs::exists(file))
+        throw std::runtime_error("cannot open " + file);
+    rememberVault(file);
+
+    // Opening only reads the vault, under a shared lock: any number of sessions can open it at once,
+    // and the generation tells the save whether another session committed in the meantime. The vault
+    // is opened once; the generation comes from the header readPipeline() reads anyway.
+    std::uint64_t generation = 0;
+    if (fs::file_size(file) > 0) {
+        std::string password = readPassword();
+        auto opening = std::chrono::steady_clock::now();
+        VaultLock lock(file, VaultLock::SHARED);
+        std::ifstream stream(file, std::ios::binary);
+        if (!stream)
+            throw std::runtime_error("cannot open " + file);
+        VaultInfo info;
+        if (stream.peek() != std::ifstream::traits_type::eof())
+            passwords = readPipeline(stream, password, nullptr, &info);
+        generation = info.generation;
+        // A compressed vault stays compressed when this session saves it.
+        if (info.compressed)
+            settings().compress = true;
+
+        auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+        std::cout << ">>> Vault ready: selection " << ms(started, selected) << " ms, opening "
+                  << ms(opening, std::chrono::steady_clock::now()) << " ms.\n";
     }
 
-    userInterface(file, passwords);
-}
\ No newline at end of file
+    userInterface(file, passwords, generation);
+
+    passwords.clear();
+    secretArena().wipe();
+}
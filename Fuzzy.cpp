@@ -0,0 +1,130 @@
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cctype>
+#include "header.hpp"
+
+namespace {
+
+constexpr std::size_t parallelThreshold = 10000;
+constexpr std::size_t blockBits = 64;
+
+// Myers' bit-vector algorithm: the columns of the edit distance matrix are kept as bit vectors of
+// vertical +1/-1 deltas, so every text character costs a handful of word operations. Patterns longer
+// than a word are split into blocks of 64 rows that pass their horizontal delta on to the next one.
+class FuzzyPattern {
+public:
+    explicit FuzzyPattern(const std::string& pattern)
+        : blocks((pattern.size() + blockBits - 1) / blockBits), length(pattern.size()), peq(blocks * 256) {
+        for (std::size_t i = 0; i < length; ++i)
+            peq[std::uint8_t(std::tolower((unsigned char) pattern[i])) * blocks + i / blockBits] |= std::uint64_t(1) << i % blockBits;
+        lastBit = std::uint64_t(1) << (length - 1) % blockBits;
+    }
+
+    // Smallest number of edits that turns the pattern into some substring of the text.
+    auto distance(const std::string& text, int limit) const -> int {
+        // The columns are reused per thread, so scanning a vault does not allocate per field.
+        thread_local std::vector<std::uint64_t> columns;
+        columns.assign(blocks, ~std::uint64_t(0));
+        columns.resize(2 * blocks, 0);
+        std::uint64_t* pv = columns.data();
+        std::uint64_t* mv = pv + blocks;
+        auto score = (int) length;
+        auto best = score;
+
+        for (char c : text) {
+            const std::uint64_t* eqs = &peq[(std::uint8_t) std::tolower((unsigned char) c) * blocks];
+            // The first row is all zeros, since a match may start anywhere in the text.
+            int carry = 0;
+            for (std::size_t b = 0; b < blocks; ++b) {
+                std::uint64_t eq = eqs[b];
+                std::uint64_t xv = eq | mv[b];
+                if (carry < 0)
+                    eq |= 1;
+                std::uint64_t xh = (((eq & pv[b]) + pv[b]) ^ pv[b]) | eq;
+                std::uint64_t ph = mv[b] | ~(xh | pv[b]);
+                std::uint64_t mh = pv[b] & xh;
+                auto highBit = b + 1 == blocks ? lastBit : std::uint64_t(1) << (blockBits - 1);
+                auto out = (ph & highBit) ? 1 : (mh & highBit) ? -1 : 0;
+                ph <<= 1;
+                mh <<= 1;
+                if (carry < 0)
+                    mh |= 1;
+                else if (carry > 0)
+                    ph |= 1;
+                pv[b] = mh | ~(xv | ph);
+                mv[b] = ph & xv;
+                carry = out;
+            }
+            score += carry;
+            best = std::min(best, score);
+            if (best == 0)
+                break;
+        }
+        return best <= limit ? best : limit + 1;
+    }
+
+private:
+    std::size_t blocks;
+    std::size_t length;
+    std::vector<std::uint64_t> peq;
+    std::uint64_t lastBit = 0;
+};
+
+auto bestField(const FuzzyPattern& pattern, const PasswordData& p, int maxErrors) -> FuzzyMatch {
+    FuzzyMatch match{0, maxErrors + 1, FuzzyField::NAME};
+    auto consider = [&](const std::string& text, FuzzyField field) {
+        auto distance = pattern.distance(text, maxErrors);
+        if (distance < match.distance) {
+            match.distance = distance;
+            match.field = field;
+        }
+    };
+    consider(p.name, FuzzyField::NAME);
+    if (p.website.has_value())
+        consider(p.website.value(), FuzzyField::WEBSITE);
+    if (p.login.has_value())
+        consider(p.login.value(), FuzzyField::LOGIN);
+    return match;
+}
+
+}
+
+auto fuzzySearch(const std::vector<PasswordData>& passwords, const std::string& pattern, int maxErrors) -> std::vector<FuzzyMatch> {
+    if (pattern.empty())
+        return {};
+
+    FuzzyPattern compiled(pattern);
+    auto scan = [&](std::size_t begin, std::size_t end, std::vector<FuzzyMatch>& out) {
+        for (auto i = begin; i < end; ++i) {
+            FuzzyMatch match = bestField(compiled, passwords[i], maxErrors);
+            if (match.distance <= maxErrors) {
+                match.index = i;
+                out.push_back(match);
+            }
+        }
+    };
+
+    std::size_t threadCount = passwords.size() < parallelThreshold ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::vector<FuzzyMatch>> partial(threadCount);
+    std::vector<std::thread> threads;
+    auto chunk = (passwords.size() + threadCount - 1) / threadCount;
+    for (std::size_t t = 1; t < threadCount; ++t)
+        threads.emplace_back(scan, std::min(t * chunk, passwords.size()), std::min((t + 1) * chunk, passwords.size()), std::ref(partial[t]));
+    scan(0, std::min(chunk, passwords.size()), partial[0]);
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<FuzzyMatch> matches;
+    for (auto& part : partial)
+        matches.insert(matches.end(), part.begin(), part.end());
+
+    std::ranges::stable_sort(matches, [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        if (a.distance != b.distance)
+            return a.distance < b.distance;
+        return a.field < b.field;
+    });
+    return matches;
+}
@@ -0,0 +1,304 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <chrono>
+#include <iomanip>
+#include "header.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string versionTag = "[VERSION] ";
+constexpr std::uint64_t checkpointInterval = 16;
+
+struct HistoryEntry {
+    std::uint64_t version;
+    bool full;
+    std::size_t records;
+    std::string timestamp;
+    std::string blob;
+};
+
+struct HistoryFile {
+    std::string header;
+    std::vector<HistoryEntry> entries;
+};
+
+auto splitLines(std::string_view text) -> std::vector<std::string_view> {
+    std::vector<std::string_view> lines;
+    while (!text.empty()) {
+        auto newline = text.find('\n');
+        lines.push_back(text.substr(0, newline));
+        if (newline == std::string_view::npos)
+            break;
+        text.remove_prefix(newline + 1);
+    }
+    return lines;
+}
+
+auto loadHistory(const std::string& path) -> HistoryFile {
+    HistoryFile history;
+    std::ifstream input(path);
+    std::string line;
+
+    while (std::getline(input, line)) {
+        if (line.starts_with(vaultHeaderTag)) {
+            history.header = line;
+        } else if (line.starts_with(versionTag)) {
+            std::istringstream iss(line.substr(versionTag.size()));
+            HistoryEntry entry;
+            std::string kind, date, time, blob;
+            iss >> entry.version >> kind >> entry.records >> date >> time >> blob;
+            entry.full = kind == "FULL";
+            entry.timestamp = date + " " + time;
+            entry.blob = fromHex(blob);
+            history.entries.push_back(std::move(entry));
+        }
+    }
+    return history;
+}
+
+auto historyKey(const std::string& header, const std::string& password) -> std::string {
+    return makeCipherEngine(header, password)->recordKey();
+}
+
+// Versions are decrypted into the secret arena; the plain text copies needed to decompress them are wiped.
+auto openEntry(const std::string& key, const HistoryEntry& entry) -> SecureString {
+    SecureString plain = openSecret(key, entry.blob);
+    if (!isCompressed(plain))
+        return plain;
+    std::string packed(plain);
+    std::string text = decompressText(packed);
+    SecureString out(text.begin(), text.end());
+    wipeString(packed);
+    wipeString(text);
+    return out;
+}
+
+// Rebuilds the lines of entries[position] from the closest checkpoint before it. The returned views
+// point into buffers, which must outlive them.
+auto materialize(const HistoryFile& history, const std::string& key, std::size_t position,
+                 std::deque<SecureString>& buffers) -> std::vector<std::string_view> {
+    auto checkpoint = position;
+    while (!history.entries[checkpoint].full) {
+        if (checkpoint == 0)
+            throw std::runtime_error("history has no checkpoint");
+        --checkpoint;
+    }
+
+    std::vector<std::string_view> lines;
+    for (auto i = checkpoint; i <= position; ++i) {
+        const SecureString& payload = buffers.emplace_back(openEntry(key, history.entries[i]));
+        if (history.entries[i].full) {
+            lines = splitLines(payload);
+            continue;
+        }
+
+        std::vector<std::string_view> next;
+        for (std::string_view op : splitLines(payload)) {
+            if (op.starts_with('+')) {
+                next.push_back(op.substr(1));
+            } else if (op.starts_with('=')) {
+                std::istringstream iss{std::string(op.substr(1))};
+                std::size_t start, count;
+                iss >> start >> count;
+                if (start > lines.size() || count > lines.size() - start)
+                    throw std::runtime_error("corrupted history");
+                next.insert(next.end(), lines.begin() + start, lines.begin() + start + count);
+            }
+        }
+        lines = std::move(next);
+    }
+    return lines;
+}
+
+// Describes current as runs copied from previous ("=start count") and new lines ("+line").
+auto makeDelta(const std::vector<std::string_view>& previous, const std::vector<std::string_view>& current) -> std::string {
+    std::unordered_map<std::string_view, std::size_t> positions;
+    for (auto i = previous.size(); i-- > 0;)
+        positions[previous[i]] = i;
+
+    std::string delta;
+    std::size_t runStart = 0, runEnd = 0;
+    auto flush = [&] {
+        if (runEnd > runStart)
+            delta += "=" + std::to_string(runStart) + " " + std::to_string(runEnd - runStart) + "\n";
+        runStart = runEnd = 0;
+    };
+
+    for (std::string_view line : current) {
+        if (runEnd > runStart && runEnd < previous.size() && previous[runEnd] == line) {
+            ++runEnd;
+            continue;
+        }
+        flush();
+        if (auto it = positions.find(line); it != positions.end()) {
+            runStart = it->second;
+            runEnd = runStart + 1;
+        } else {
+            delta += "+";
+            delta += line;
+            delta += '\n';
+        }
+    }
+    flush();
+    return delta;
+}
+
+auto formatEntry(std::uint64_t version, bool full, std::size_t records, const std::string& timestamp,
+                 const std::string& blob) -> std::string {
+    return versionTag + std::to_string(version) + ' ' + (full ? "FULL" : "DELTA") + ' ' + std::to_string(records) + ' '
+           + timestamp + ' ' + toHex(blob) + '\n';
+}
+
+auto findVersion(const HistoryFile& history, std::uint64_t version) -> std::size_t {
+    for (auto i = 0; i < history.entries.size(); ++i) {
+        if (history.entries[i].version == version)
+            return i;
+    }
+    throw std::runtime_error("version " + std::to_string(version) + " not found in history");
+}
+
+auto listHistory(const std::string& file) -> void {
+    HistoryFile history = loadHistory(historyPath(file));
+    if (history.entries.empty()) {
+        std::cout << ">>> No history for " << file << ".\n";
+        return;
+    }
+
+    std::size_t historySize = 0, fullSize = 0;
+    std::cout << ">>> History of " << file << ":\n";
+    for (const HistoryEntry& entry : history.entries) {
+        std::cout << std::setw(6) << entry.version << "  " << entry.timestamp << "  " << (entry.full ? "FULL " : "DELTA")
+                  << "  " << std::setw(8) << entry.records << " password(s)  " << entry.blob.size() << " bytes\n";
+        historySize += entry.blob.size();
+    }
+    if (fs::exists(file))
+        fullSize = fs::file_size(file) * history.entries.size();
+    if (fullSize > 0)
+        std::cout << ">>> History takes " << historySize << " bytes, " << std::fixed << std::setprecision(1)
+                  << 100.0 * historySize / fullSize << "% of " << history.entries.size() << " full copies.\n"
+                  << std::defaultfloat;
+}
+
+}
+
+auto historyPath(const std::string& file) -> std::string {
+    return file + ".history";
+}
+
+auto recordHistory(const std::string& file, const std::string& password, const std::string& data) -> void {
+    std::string path = historyPath(file);
+    HistoryFile history = loadHistory(path);
+    std::deque<SecureString> buffers;
+    std::vector<std::string_view> previous;
+    std::string key;
+
+    if (!history.header.empty()) {
+        key = historyKey(history.header, password);
+        try {
+            if (!history.entries.empty())
+                previous = materialize(history, key, history.entries.size() - 1, buffers);
+        } catch (const std::exception& e) {
+            setAside(path, "History", e.what());
+            history = HistoryFile();
+        }
+    }
+
+    std::ofstream output(path, std::ios::app);
+    if (history.header.empty()) {
+        history.header = newVaultHeader();
+        key = historyKey(history.header, password);
+        output << history.header << '\n';
+    }
+
+    std::vector<std::string_view> current = splitLines(data);
+    auto version = history.entries.empty() ? 1 : history.entries.back().version + 1;
+    auto sinceCheckpoint = std::uint64_t(0);
+    for (auto it = history.entries.rbegin(); it != history.entries.rend() && !it->full; ++it)
+        ++sinceCheckpoint;
+
+    std::string payload;
+    bool full = history.entries.empty() || sinceCheckpoint + 1 >= checkpointInterval;
+    if (!full) {
+        payload = makeDelta(previous, current);
+        full = payload.size() * 2 >= data.size();
+    }
+    if (full)
+        payload = data;
+
+    std::string packed = compressText(payload);
+    std::string blob = sealSecret(key, version, packed);
+    wipeString(packed);
+    wipeString(payload);
+    output << formatEntry(version, full, current.size(), currentTimestamp(), blob);
+}
+
+auto rekeyHistory(const std::string& file, const std::string& oldPassword, const std::string& newPassword) -> std::string {
+    std::string path = historyPath(file);
+    HistoryFile history = loadHistory(path);
+    if (history.header.empty())
+        return "";
+
+    // Versions are resealed as they are (still compressed), so no delta has to be rebuilt.
+    std::string oldKey = historyKey(history.header, oldPassword);
+    std::string header = newVaultHeader();
+    std::string newKey = historyKey(header, newPassword);
+    std::string text = header + '\n';
+    for (const HistoryEntry& entry : history.entries) {
+        SecureString payload = openSecret(oldKey, entry.blob);
+        text += formatEntry(entry.version, entry.full, entry.records, entry.timestamp,
+                            sealSecret(newKey, entry.version, std::string_view(payload)));
+    }
+    std::string staged = path + ".rekey";
+    fileModify(staged, text);
+    return staged;
+}
+
+auto historyVersion(const std::string& file, const std::string& password, std::uint64_t version) -> std::vector<PasswordData> {
+    HistoryFile history = loadHistory(historyPath(file));
+    if (history.header.empty())
+        throw std::runtime_error("no history for " + file);
+
+    std::deque<SecureString> buffers;
+    std::vector<PasswordData> passwords;
+    for (std::string_view line : materialize(history, historyKey(history.header, password), findVersion(history, version), buffers))
+        passwords.push_back(parseLine(line));
+    return passwords;
+}
+
+auto historyCommand(const std::vector<std::string>& args) -> void {
+    if (args.size() < 2)
+        throw std::runtime_error("usage: --history VAULT [show|restore VERSION]");
+    const std::string& file = args[1];
+
+    if (args.size() < 4) {
+        listHistory(file);
+        return;
+    }
+
+    std::uint64_t version = std::stoull(args[3]);
+    std::string password = readPassword();
+    std::vector<PasswordData> passwords = historyVersion(file, password, version);
+
+    if (args[2] == "show") {
+        for (const PasswordData& p : passwords)
+            printPassword(p);
+        std::cout << ">>> Version " << version << ": " << passwords.size() << " password(s).\n";
+    } else if (args[2] == "restore") {
+        passwordsSave(passwords, file, password);
+        std::cout << ">>> Restored version " << version << " of " << file << ".\n";
+    } else {
+        throw std::runtime_error("unknown history command " + args[2]);
+    }
+
+    passwords.clear();
+    secretArena().wipe();
+}
@@ -0,0 +1,264 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <unordered_map>
+#include <functional>
+#include <filesystem>
+#include "header.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// The fields merged independently; website and login are only ever set together.
+enum MergeField {
+    PASSWORD,
+    CATEGORY,
+    SITE,
+    FIELD_COUNT
+};
+
+const std::array<std::string, FIELD_COUNT> fieldNames = {"password", "category", "website/login"};
+
+struct Fingerprint {
+    const PasswordData* data;
+    std::size_t record;
+    std::array<std::size_t, FIELD_COUNT> fields;
+};
+
+auto fingerprint(const PasswordData& p) -> Fingerprint {
+    std::hash<std::string_view> hash;
+    Fingerprint print{&p};
+    print.fields[PASSWORD] = hash(std::string_view(p.password.value()));
+    print.fields[CATEGORY] = hash(p.category);
+    print.fields[SITE] = p.website.has_value() ? hash(p.website.value() + '\n' + p.login.value_or("")) : 0;
+    print.record = hash(p.name);
+    for (auto field : print.fields)
+        print.record = print.record * 1000003 ^ field;
+    return print;
+}
+
+// Hashes only rule values out; equal hashes are confirmed on the values, so a collision cannot hide a change.
+auto sameField(const Fingerprint& x, const Fingerprint& y, int field) -> bool {
+    if (x.fields[field] != y.fields[field])
+        return false;
+    const PasswordData& a = *x.data;
+    const PasswordData& b = *y.data;
+    switch (field) {
+        case PASSWORD:
+            return std::string_view(a.password.value()) == std::string_view(b.password.value());
+        case CATEGORY:
+            return a.category == b.category;
+        default:
+            return a.website == b.website && (!a.website || a.login == b.login);
+    }
+}
+
+auto sameRecord(const Fingerprint& x, const Fingerprint& y) -> bool {
+    if (x.record != y.record || x.data->name != y.data->name)
+        return false;
+    for (auto field = 0; field < FIELD_COUNT; ++field) {
+        if (!sameField(x, y, field))
+            return false;
+    }
+    return true;
+}
+
+// Identical names are told apart by their occurrence, so duplicates still pair up in order.
+auto recordKeys(const std::vector<PasswordData>& passwords) -> std::vector<std::string> {
+    std::unordered_map<std::string_view, std::size_t> seen;
+    std::vector<std::string> keys;
+    keys.reserve(passwords.size());
+    for (const PasswordData& p : passwords) {
+        auto occurrence = seen[p.name]++;
+        keys.push_back(occurrence == 0 ? p.name : p.name + '#' + std::to_string(occurrence));
+    }
+    return keys;
+}
+
+struct Side {
+    const std::vector<PasswordData>& passwords;
+    std::vector<std::string> keys;
+    std::vector<Fingerprint> prints;
+    std::unordered_map<std::string_view, std::size_t> byKey;
+
+    explicit Side(const std::vector<PasswordData>& passwords) : passwords(passwords), keys(recordKeys(passwords)) {
+        prints.reserve(passwords.size());
+        byKey.reserve(passwords.size());
+        for (auto i = 0; i < passwords.size(); ++i) {
+            prints.push_back(fingerprint(passwords[i]));
+            byKey.emplace(keys[i], i);
+        }
+    }
+
+    auto find(std::string_view key) const -> const Fingerprint* {
+        auto it = byKey.find(key);
+        return it == byKey.end() ? nullptr : &prints[it->second];
+    }
+
+    auto record(std::string_view key) const -> const PasswordData& {
+        return passwords[byKey.at(key)];
+    }
+};
+
+auto copyField(PasswordData& to, const PasswordData& from, MergeField field) -> void {
+    switch (field) {
+        case PASSWORD:
+            to.password = from.password;
+            break;
+        case CATEGORY:
+            to.category = from.category;
+            break;
+        default:
+            to.website = from.website;
+            to.login = from.login;
+    }
+}
+
+}
+
+auto mergeVaults(const std::vector<PasswordData>& base, const std::vector<PasswordData>& ours,
+                 const std::vector<PasswordData>& theirs, bool preferTheirs) -> MergeResult {
+    MergeResult result;
+    Side baseSide(base), ourSide(ours), theirSide(theirs);
+
+    // Decides one record; o and t are null when the record is missing on that side.
+    auto merge = [&](std::string_view key, const Fingerprint* o, const Fingerprint* t) {
+        const Fingerprint* b = baseSide.find(key);
+        auto same = [](const Fingerprint* x, const Fingerprint* y) {
+            return x == y || (x && y && sameRecord(*x, *y));
+        };
+
+        if (same(o, t)) {
+            if (o)
+                result.merged.push_back(ourSide.record(key));
+            return;
+        }
+        if (same(o, b)) {
+            ++result.fromTheirs;
+            if (t)
+                result.merged.push_back(theirSide.record(key));
+            return;
+        }
+        if (same(t, b)) {
+            ++result.fromOurs;
+            if (o)
+                result.merged.push_back(ourSide.record(key));
+            return;
+        }
+        if (!o || !t) {
+            // Deleted on one side, changed on the other: the changed record is kept.
+            const std::string side = o ? "theirs" : "ours";
+            result.merged.push_back(o ? ourSide.record(key) : theirSide.record(key));
+            result.conflicts.push_back(std::string(key) + ": changed in " + (o ? "ours" : "theirs") + ", deleted in " + side);
+            return;
+        }
+
+        // Changed on both sides: merge field by field.
+        PasswordData record = ourSide.record(key);
+        ++result.fieldMerged;
+        for (auto field = 0; field < FIELD_COUNT; ++field) {
+            if (sameField(*o, *t, field) || (b && sameField(*t, *b, field)))
+                continue;
+            if (b && sameField(*o, *b, field)) {
+                copyField(record, theirSide.record(key), MergeField(field));
+                continue;
+            }
+            if (preferTheirs)
+                copyField(record, theirSide.record(key), MergeField(field));
+            result.conflicts.push_back(std::string(key) + ": " + fieldNames[field] + " changed on both sides, kept "
+                                       + (preferTheirs ? "theirs" : "ours"));
+        }
+        result.merged.push_back(std::move(record));
+    };
+
+    result.merged.reserve(std::max(ours.size(), theirs.size()));
+    for (auto i = 0; i < ours.size(); ++i)
+        merge(ourSide.keys[i], &ourSide.prints[i], theirSide.find(ourSide.keys[i]));
+    for (auto i = 0; i < theirs.size(); ++i) {
+        if (!ourSide.find(theirSide.keys[i]))
+            merge(theirSide.keys[i], nullptr, &theirSide.prints[i]);
+    }
+    // Records that are only left in the base were deleted on both sides.
+    return result;
+}
+
+auto mergeCommand(const std::vector<std::string>& args) -> void {
+    if (args.size() < 4)
+        throw std::runtime_error("usage: --merge BASE OURS THEIRS [--theirs]");
+    std::vector<std::string> files(args.begin() + 1, args.begin() + 4);
+    bool preferTheirs = args.size() > 4 && args[4] == "--theirs";
+
+    std::string yesNo;
+    std::cout << "Use the same password for all vaults? (y/n): ";
+    std::cin >> yesNo;
+    while (yesNo != "y" && yesNo != "Y" && yesNo != "n" && yesNo != "N") {
+        std::cout << ">>> Please enter (y/n): ";
+        std::cin >> yesNo;
+    }
+
+    std::vector<std::string> passwords;
+    if (yesNo == "y" || yesNo == "Y") {
+        passwords.assign(files.size(), readPassword());
+    } else {
+        for (const auto& file : files) {
+            std::cout << fs::path(file).filename().string() << " - ";
+            passwords.push_back(readPassword());
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<PasswordData>> vaults(files.size());
+    std::vector<VaultInfo> infos(files.size());
+    std::vector<std::exception_ptr> errors(files.size());
+    std::vector<std::thread> threads;
+    for (auto i = 0; i < files.size(); ++i) {
+        threads.emplace_back([&, i] {
+            try {
+                vaults[i] = loadVault(files[i], passwords[i], &infos[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto i = 0; i < files.size(); ++i) {
+        if (errors[i]) {
+            std::cout << ">>> Could not open " << fs::path(files[i]) << ".\n";
+            std::rethrow_exception(errors[i]);
+        }
+    }
+    auto loaded = std::chrono::steady_clock::now();
+
+    MergeResult result = mergeVaults(vaults[0], vaults[1], vaults[2], preferTheirs);
+    auto merged = std::chrono::steady_clock::now();
+
+    for (auto i = 0; i < result.conflicts.size() && i < 50; ++i)
+        std::cout << "CONFLICT " << result.conflicts[i] << '\n';
+    if (result.conflicts.size() > 50)
+        std::cout << "... and " << result.conflicts.size() - 50 << " more conflict(s)\n";
+
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << ">>> Merged " << vaults[0].size() << " / " << vaults[1].size() << " / " << vaults[2].size()
+              << " password(s) into " << result.merged.size() << ": " << result.fromOurs << " from ours, "
+              << result.fromTheirs << " from theirs, " << result.fieldMerged << " merged field by field, "
+              << result.conflicts.size() << " conflict(s).\n"
+              << ">>> Loading took " << ms(start, loaded) << " ms, merging " << ms(loaded, merged) << " ms.\n";
+
+    // The result replaces OURS, so it keeps the compression of OURS. A session that saved OURS since
+    // it was loaded is not overwritten: its changes are merged in like those of a concurrent session.
+    if (infos[1].compressed)
+        settings().compress = true;
+    commitPasswords(vaults[1], infos[1].generation, result.merged, files[1], passwords[1]);
+
+    vaults.clear();
+    result.merged.clear();
+    secretArena().wipe();
+}
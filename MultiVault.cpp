@@ -0,0 +1,173 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include "header.hpp"
+
+namespace fs = std::filesystem;
+
+auto openVaults(const std::vector<std::string>& files, const std::vector<std::string>& passwords) -> std::vector<VaultRecord> {
+    std::vector<std::vector<PasswordData>> opened(files.size());
+    std::vector<std::string> errors(files.size());
+    std::atomic<std::size_t> next = 0;
+
+    auto worker = [&]() {
+        for (auto i = next++; i < files.size(); i = next++) {
+            try {
+                opened[i] = loadVault(files[i], passwords[i]);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        }
+    };
+
+    auto threadCount = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), files.size());
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < threadCount; ++t)
+        threads.emplace_back(worker);
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<VaultRecord> merged;
+    for (auto i = 0; i < files.size(); ++i) {
+        if (!errors[i].empty()) {
+            std::cout << ">>> Could not open " << fs::path(files[i]) << ": " << errors[i] << '\n';
+            continue;
+        }
+        std::string vault = fs::path(files[i]).filename().string();
+        for (auto& passwordData : opened[i])
+            merged.push_back(VaultRecord{vault, std::move(passwordData)});
+    }
+    return merged;
+}
+
+auto displayMerged(const std::vector<VaultRecord>& records) -> void {
+    std::cout << '\n';
+    for (const VaultRecord& record : records) {
+        printPassword(record.data);
+        std::cout << "Vault: " << record.vault << std::endl;
+    }
+}
+
+auto searchMerged(const std::vector<VaultRecord>& records) -> void {
+    std::string name, category;
+
+    std::cout << "\n>>> Search all vaults by entering NAME and CATEGORY: ";
+    std::cin >> name >> category;
+
+    auto found = false;
+    for (const VaultRecord& record : records) {
+        if (record.data.name == name || record.data.category == category) {
+            printPassword(record.data);
+            std::cout << "Vault: " << record.vault << std::endl;
+            found = true;
+        }
+    }
+    if (!found)
+        std::cout << "NO PASSWORDS FOUND.\n";
+}
+
+auto listMerged(const std::vector<VaultRecord>& records) -> void {
+    std::vector<std::pair<std::string, int>> counts;
+    for (const VaultRecord& record : records) {
+        if (counts.empty() || counts.back().first != record.vault)
+            counts.emplace_back(record.vault, 0);
+        counts.back().second++;
+    }
+
+    std::cout << '\n';
+    for (const auto& [vault, count] : counts)
+        std::cout << vault << ": " << count << " password(s)\n";
+}
+
+auto multiVaultRead() -> void {
+    std::vector<std::string> vaults = discoverVaults(defaultVaultFolder());
+
+    if (vaults.empty()) {
+        std::cout << ">>> NO VAULTS FOUND.\n";
+        return;
+    }
+
+    std::cout << ">>> Select vaults to open [NUMBERS separated by spaces, 0 to finish] or [a] for all:\n";
+    for (auto i = 0; i < vaults.size(); ++i)
+        std::cout << i + 1 << ". " << fs::path(vaults[i]) << std::endl;
+
+    std::vector<std::string> selected;
+    std::string input;
+    std::cout << "Your choice: ";
+    while (std::cin >> input && input != "0") {
+        if (input == "a" || input == "A") {
+            selected = vaults;
+            break;
+        }
+        try {
+            auto choice = std::stoi(input);
+            if (choice > 0 && choice <= vaults.size()) {
+                if (std::ranges::find(selected, vaults[choice - 1]) == selected.end())
+                    selected.push_back(vaults[choice - 1]);
+            } else
+                std::cout << ">>> THERE IS NO FILE OF GIVEN NUMBER.\n";
+        } catch (const std::exception& e) {
+            std::cout << ">>> INVALID ARGUMENT (NUMBER REQUIRED).\n";
+        }
+    }
+
+    if (selected.empty()) {
+        std::cout << ">>> NO VAULTS SELECTED.\n";
+        return;
+    }
+
+    std::string yesNo;
+    std::cout << "Use the same password for all vaults? (y/n): ";
+    std::cin >> yesNo;
+    while (yesNo != "y" && yesNo != "Y" && yesNo != "n" && yesNo != "N") {
+        std::cout << ">>> Please enter (y/n): ";
+        std::cin >> yesNo;
+    }
+
+    std::vector<std::string> passwords;
+    if (yesNo == "y" || yesNo == "Y") {
+        passwords.assign(selected.size(), readPassword());
+    } else {
+        for (const auto& file : selected) {
+            std::cout << fs::path(file).filename().string() << " - ";
+            passwords.push_back(readPassword());
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<VaultRecord> records = openVaults(selected, passwords);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    std::cout << "\n>>> Opened " << selected.size() << " vault(s), " << records.size()
+              << " password(s) in " << elapsed.count() << " ms.\n";
+
+    std::string choiceStr;
+    do {
+        std::cout << "\n>>> Choose an option:\n"
+                     "1. DISPLAY_CONTENT\n"
+                     "2. SEARCH_PASSWORDS\n"
+                     "3. LIST_VAULTS\n"
+                     "4. EXIT\n";
+        std::cout << "Your choice: ";
+        std::cin >> choiceStr;
+
+        if (choiceStr == "1")
+            displayMerged(records);
+        else if (choiceStr == "2")
+            searchMerged(records);
+        else if (choiceStr == "3")
+            listMerged(records);
+        else if (choiceStr == "4")
+            break;
+        else
+            std::cout << ">>> COMMAND NOT FOUND.\n";
+    } while (std::cin);
+
+    records.clear();
+    secretArena().wipe();
+}
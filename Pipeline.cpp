@@ -0,0 +1,326 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <fstream>
+#include <functional>
+#include <exception>
+#include <stdexcept>
+#include <cctype>
+#include <numeric>
+#include <algorithm>
+#include "header.hpp"
+
+namespace {
+
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity(capacity) {}
+
+    auto push(T item) -> bool {
+        std::unique_lock lock(mutex);
+        notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+        if (closed)
+            return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    auto pop() -> std::optional<T> {
+        std::unique_lock lock(mutex);
+        notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+        if (items.empty())
+            return std::nullopt;
+        T item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    auto close() -> void {
+        std::lock_guard lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+private:
+    std::size_t capacity;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+    bool closed = false;
+};
+
+constexpr std::size_t blockSize = 64 * 1024;
+constexpr std::size_t queueDepth = 8;
+
+auto readBlocks(std::istream& stream, BoundedQueue<std::string>& out, BlockVerifier* verifier) -> void {
+    auto atLineStart = true;
+    auto skipping = false;
+    std::string buffer(blockSize, '\0');
+
+    while (stream.read(buffer.data(), blockSize) || stream.gcount() > 0) {
+        std::string block;
+        block.reserve(stream.gcount());
+        for (auto i = 0; i < stream.gcount(); ++i) {
+            char c = buffer[i];
+            if (atLineStart)
+                skipping = c == '[';
+            atLineStart = c == '\n';
+            if (!skipping)
+                block += c;
+        }
+        if (verifier) {
+            // The body is one line; its newline and the lines after it are not checksummed.
+            std::string_view rest = block;
+            for (auto newline = rest.find('\n'); newline != std::string_view::npos; newline = rest.find('\n')) {
+                verifier->update(rest.substr(0, newline));
+                rest.remove_prefix(newline + 1);
+            }
+            verifier->update(rest);
+        }
+        if (!block.empty() && !out.push(std::move(block)))
+            return;
+    }
+    if (verifier)
+        verifier->finish();
+}
+
+auto decryptBlocks(CipherEngine& engine, BoundedQueue<std::string>& in, BoundedQueue<std::string>& out) -> void {
+    std::string pending;
+    std::string tail;
+
+    while (auto block = in.pop()) {
+        for (char c : *block) {
+            if (std::isxdigit((unsigned char) c))
+                pending += c;
+        }
+        auto whole = pending.size() & ~std::size_t(1);
+        std::string plain = tail + fromHex(pending.substr(0, whole));
+        pending.erase(0, whole);
+
+        auto keep = std::min(plain.size(), engine.tagSize());
+        tail = plain.substr(plain.size() - keep);
+        plain.resize(plain.size() - keep);
+
+        engine.decrypt(plain);
+        if (!out.push(std::move(plain)))
+            return;
+    }
+    if (tail.size() < engine.tagSize())
+        throw std::runtime_error("wrong password or corrupted vault");
+    engine.finish(tail);
+}
+}
+
+auto readPipeline(const std::string& file, const std::string& password,
+                  const std::function<void(const PasswordData&)>& onUnverifiedRecord, VaultInfo* info) -> std::vector<PasswordData> {
+    std::ifstream stream(file, std::ios::binary);
+    if (!stream)
+        throw std::runtime_error("cannot open " + file);
+    return readPipeline(stream, password, onUnverifiedRecord, info);
+}
+
+auto readPipeline(std::istream& stream, const std::string& password,
+                  const std::function<void(const PasswordData&)>& onUnverifiedRecord, VaultInfo* info) -> std::vector<PasswordData> {
+    std::string header;
+    if (stream.peek() == '[') {
+        std::getline(stream, header);
+        if (!header.starts_with(vaultHeaderTag))
+            header.clear();
+    }
+    if (info)
+        info->generation = headerGeneration(header);
+    std::optional<BlockVerifier> verifier;
+    if (!header.empty() && stream.peek() == '[') {
+        std::string table;
+        std::getline(stream, table);
+        if (isBlockTable(table))
+            verifier.emplace(parseBlockTable(table));
+    }
+    // The secrets section is only decoded; the secrets stay sealed in the records.
+    SealedSecrets secrets;
+    if (verifier && stream.peek() == '[') {
+        std::string line;
+        std::getline(stream, line);
+        if (isSecretsSection(line))
+            secrets = parseSecretsSection(line);
+    }
+    auto engine = makeCipherEngine(header, password);
+    std::string recordKey = engine->recordKey();
+    RecordKey key = recordKey.empty() ? nullptr : std::make_shared<const std::string>(std::move(recordKey));
+    if (header.empty())
+        std::cout << ">>> Legacy XOR vault: it will be re-encrypted with ChaCha20-Poly1305 when saved.\n";
+
+    BoundedQueue<std::string> encrypted(queueDepth);
+    BoundedQueue<std::string> decrypted(queueDepth);
+    std::exception_ptr readError, decryptError;
+
+    std::thread reader([&] {
+        try {
+            readBlocks(stream, encrypted, verifier ? &*verifier : nullptr);
+        } catch (...) {
+            readError = std::current_exception();
+        }
+        encrypted.close();
+    });
+    std::thread decrypter([&] {
+        try {
+            decryptBlocks(*engine, encrypted, decrypted);
+        } catch (...) {
+            decryptError = std::current_exception();
+        }
+        encrypted.close();
+        decrypted.close();
+    });
+
+    // Decrypted text is cut at line ends into chunks that parser threads turn into their own blocks of
+    // records while decryption goes on; the blocks are joined in file order at the end. A block is handed
+    // to onUnverifiedRecord as soon as it and every block before it are parsed, which is before the
+    // tag of an authenticated vault is checked.
+    struct ParsedBlock {
+        std::vector<PasswordData> records;
+        bool done = false;
+    };
+    struct ParseTask {
+        std::string text;
+        ParsedBlock* block;
+    };
+    BoundedQueue<ParseTask> tasks(queueDepth);
+    std::deque<ParsedBlock> blocks;
+    std::mutex blocksMutex;
+    std::condition_variable blockParsed;
+    auto parserCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> parsers;
+    std::vector<std::exception_ptr> parseErrors(parserCount);
+    for (std::size_t t = 0; t < parserCount; ++t) {
+        parsers.emplace_back([&, t] {
+            try {
+                while (auto task = tasks.pop()) {
+                    std::vector<PasswordData> records = parseRecords(task->text, key, 1, &secrets);
+                    std::lock_guard<std::mutex> lock(blocksMutex);
+                    task->block->records = std::move(records);
+                    task->block->done = true;
+                    blockParsed.notify_one();
+                }
+            } catch (...) {
+                parseErrors[t] = std::current_exception();
+                tasks.close();
+            }
+        });
+    }
+    auto stopParsers = [&] {
+        tasks.close();
+        for (auto& parser : parsers) {
+            if (parser.joinable())
+                parser.join();
+        }
+    };
+    auto rethrowParseError = [&] {
+        for (const auto& error : parseErrors) {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    };
+    auto stopStages = [&] {
+        encrypted.close();
+        decrypted.close();
+        if (reader.joinable())
+            reader.join();
+        if (decrypter.joinable())
+            decrypter.join();
+    };
+    auto dispatch = [&](std::string text) {
+        blocks.emplace_back();
+        if (!tasks.push(ParseTask{std::move(text), &blocks.back()})) {
+            stopParsers();
+            rethrowParseError();
+        }
+    };
+    std::size_t nextBlock = 0;
+    auto deliver = [&] {
+        if (!onUnverifiedRecord)
+            return;
+        while (nextBlock < blocks.size()) {
+            {
+                std::lock_guard<std::mutex> lock(blocksMutex);
+                if (!blocks[nextBlock].done)
+                    return;
+            }
+            for (const PasswordData& passwordData : blocks[nextBlock].records)
+                onUnverifiedRecord(passwordData);
+            ++nextBlock;
+        }
+    };
+
+    std::vector<PasswordData> result;
+    try {
+        auto first = true;
+        auto compressed = false;
+        std::string packed, pending;
+        while (auto block = decrypted.pop()) {
+            if (first) {
+                compressed = isCompressed(*block);
+                if (info)
+                    info->compressed = compressed;
+            }
+            first = false;
+            if (compressed) {
+                packed += *block;
+                continue;
+            }
+
+            pending += *block;
+            if (pending.size() >= minimumParseChunk) {
+                auto newline = pending.rfind('\n');
+                if (newline != std::string::npos) {
+                    std::string rest = pending.substr(newline + 1);
+                    pending.resize(newline + 1);
+                    dispatch(std::move(pending));
+                    pending = std::move(rest);
+                }
+            }
+            deliver();
+        }
+        // A damaged or wrongly keyed vault is reported as such before any partial text is parsed.
+        stopStages();
+        if (readError)
+            std::rethrow_exception(readError);
+        if (decryptError)
+            std::rethrow_exception(decryptError);
+
+        if (!pending.empty())
+            dispatch(std::move(pending));
+        stopParsers();
+        rethrowParseError();
+        deliver();
+
+        result.reserve(std::accumulate(blocks.begin(), blocks.end(), std::size_t(0),
+                                       [](std::size_t sum, const auto& block) { return sum + block.records.size(); }));
+        for (auto& block : blocks)
+            result.insert(result.end(), std::make_move_iterator(block.records.begin()), std::make_move_iterator(block.records.end()));
+        if (!packed.empty()) {
+            for (PasswordData& passwordData : splitString(packed, key, &secrets)) {
+                if (onUnverifiedRecord)
+                    onUnverifiedRecord(passwordData);
+                result.push_back(std::move(passwordData));
+            }
+        }
+    } catch (...) {
+        stopParsers();
+        stopStages();
+        if (readError)
+            std::rethrow_exception(readError);
+        if (decryptError)
+            std::rethrow_exception(decryptError);
+        throw;
+    }
+    return result;
+}
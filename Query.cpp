@@ -0,0 +1,325 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <thread>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+#include <cstdint>
+#include "header.hpp"
+
+namespace {
+
+enum QueryField {
+    NAME,
+    CATEGORY,
+    WEBSITE,
+    LOGIN,
+    ANY
+};
+
+const std::array<std::string, 4> fieldNames = {"name", "category", "website", "login"};
+constexpr std::size_t parallelThreshold = 10000;
+
+auto fold(char c) -> char {
+    return (char) std::tolower((unsigned char) c);
+}
+
+auto equalFolded(std::string_view a, std::string_view b) -> bool {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return fold(x) == fold(y); });
+}
+
+// Case-insensitive glob with '*' and '?', backtracking to the last '*' on a mismatch.
+auto globMatch(std::string_view pattern, std::string_view text) -> bool {
+    std::size_t p = 0, t = 0, star = std::string_view::npos, resume = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || fold(pattern[p]) == fold(text[t]))) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = t;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            t = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+    return p == pattern.size();
+}
+
+// Glob patterns are classified once, so the common shapes are matched without backtracking.
+struct Matcher {
+    enum Shape { EXACT, PREFIX, SUFFIX, CONTAINS, GLOB } shape;
+    std::string pattern;
+    std::string literal;
+
+    explicit Matcher(const std::string& glob) : pattern(glob) {
+        bool leading = glob.starts_with('*'), trailing = glob.size() > 1 && glob.ends_with('*');
+        std::string core = glob.substr(leading, glob.size() - leading - trailing);
+
+        if (glob.find_first_of("*?") == std::string::npos)
+            shape = EXACT;
+        else if (core.find_first_of("*?") != std::string::npos)
+            shape = GLOB;
+        else if (leading && trailing)
+            shape = CONTAINS;
+        else if (leading)
+            shape = SUFFIX;
+        else
+            shape = PREFIX;
+        literal = shape == EXACT ? glob : core;
+    }
+
+    auto operator()(std::string_view text) const -> bool {
+        switch (shape) {
+            case EXACT:
+                return equalFolded(text, literal);
+            case PREFIX:
+                return text.size() >= literal.size() && equalFolded(text.substr(0, literal.size()), literal);
+            case SUFFIX:
+                return text.size() >= literal.size() && equalFolded(text.substr(text.size() - literal.size()), literal);
+            case CONTAINS:
+                return std::search(text.begin(), text.end(), literal.begin(), literal.end(),
+                                   [](char x, char y) { return fold(x) == fold(y); }) != text.end();
+            default:
+                return globMatch(pattern, text);
+        }
+    }
+};
+
+using Rows = std::vector<std::uint32_t>;
+
+// One pointer per record for every field; missing websites and logins are null.
+using Columns = std::array<std::vector<const std::string*>, 4>;
+
+auto without(const Rows& rows, const Rows& removed) -> Rows {
+    Rows rest;
+    rest.reserve(rows.size() - removed.size());
+    std::ranges::set_difference(rows, removed, std::back_inserter(rest));
+    return rest;
+}
+
+}
+
+struct QueryNode {
+    enum Kind { AND, OR, NOT, MATCH } kind;
+    std::unique_ptr<const QueryNode> left;
+    std::unique_ptr<const QueryNode> right;
+    QueryField field = ANY;
+    std::optional<Matcher> matcher;
+
+    // Keeps the rows (sorted) for which the node holds. Each node only looks at the rows the nodes
+    // before it left undecided, so AND and OR short-circuit over whole columns.
+    auto select(const Columns& columns, Rows rows) const -> Rows {
+        switch (kind) {
+            case AND:
+                return right->select(columns, left->select(columns, std::move(rows)));
+            case OR: {
+                Rows matched = left->select(columns, rows);
+                Rows more = right->select(columns, without(rows, matched));
+                Rows merged;
+                merged.reserve(matched.size() + more.size());
+                std::ranges::merge(matched, more, std::back_inserter(merged));
+                return merged;
+            }
+            case NOT:
+                return without(rows, left->select(columns, rows));
+            default:
+                return scan(columns, rows);
+        }
+    }
+
+    auto scan(const Columns& columns, const Rows& rows) const -> Rows {
+        Rows kept;
+        auto scanColumn = [&](const std::vector<const std::string*>& column) {
+            for (auto row : rows) {
+                if (column[row] && (*matcher)(*column[row]))
+                    kept.push_back(row);
+            }
+        };
+
+        if (field != ANY) {
+            scanColumn(columns[field]);
+            return kept;
+        }
+        for (auto row : rows) {
+            if (std::ranges::any_of(columns, [&](const auto& column) { return column[row] && (*matcher)(*column[row]); }))
+                kept.push_back(row);
+        }
+        return kept;
+    }
+};
+
+namespace {
+
+auto tokenize(const std::string& text) -> std::vector<std::string> {
+    std::vector<std::string> tokens;
+    std::string current;
+    for (char c : text) {
+        if (std::isspace((unsigned char) c) || c == '(' || c == ')') {
+            if (!current.empty())
+                tokens.push_back(std::move(current));
+            current.clear();
+            if (c == '(' || c == ')')
+                tokens.emplace_back(1, c);
+        } else {
+            current += c;
+        }
+    }
+    if (!current.empty())
+        tokens.push_back(std::move(current));
+    return tokens;
+}
+
+// Recursive descent: or := and (OR and)*, and := not ([AND] not)*, not := NOT not | '(' or ')' | term.
+class QueryParser {
+public:
+    explicit QueryParser(const std::string& text) : tokens(tokenize(text)) {}
+
+    auto parse() -> std::unique_ptr<const QueryNode> {
+        if (tokens.empty())
+            throw std::invalid_argument("empty query");
+        auto node = parseOr();
+        if (position < tokens.size())
+            throw std::invalid_argument("unexpected '" + tokens[position] + "'");
+        return node;
+    }
+
+private:
+    auto peek() const -> std::string {
+        return position < tokens.size() ? tokens[position] : "";
+    }
+
+    static auto join(QueryNode::Kind kind, std::unique_ptr<const QueryNode> left, std::unique_ptr<const QueryNode> right)
+        -> std::unique_ptr<const QueryNode> {
+        auto node = std::make_unique<QueryNode>();
+        node->kind = kind;
+        node->left = std::move(left);
+        node->right = std::move(right);
+        return node;
+    }
+
+    auto parseOr() -> std::unique_ptr<const QueryNode> {
+        auto node = parseAnd();
+        while (peek() == "OR") {
+            ++position;
+            node = join(QueryNode::OR, std::move(node), parseAnd());
+        }
+        return node;
+    }
+
+    auto parseAnd() -> std::unique_ptr<const QueryNode> {
+        auto node = parseNot();
+        while (position < tokens.size() && peek() != "OR" && peek() != ")") {
+            if (peek() == "AND")
+                ++position;
+            node = join(QueryNode::AND, std::move(node), parseNot());
+        }
+        return node;
+    }
+
+    auto parseNot() -> std::unique_ptr<const QueryNode> {
+        std::string token = peek();
+        if (token.empty() || token == ")" || token == "AND" || token == "OR")
+            throw std::invalid_argument(token.empty() ? "unexpected end of query" : "unexpected '" + token + "'");
+        ++position;
+
+        if (token == "NOT")
+            return join(QueryNode::NOT, parseNot(), nullptr);
+        if (token == "(") {
+            auto node = parseOr();
+            if (peek() != ")")
+                throw std::invalid_argument("missing ')'");
+            ++position;
+            return node;
+        }
+
+        auto node = std::make_unique<QueryNode>();
+        node->kind = QueryNode::MATCH;
+        std::string pattern = token;
+        if (auto colon = token.find(':'); colon != std::string::npos) {
+            std::string name = token.substr(0, colon);
+            std::ranges::transform(name, name.begin(), fold);
+            if (auto it = std::ranges::find(fieldNames, name); it != fieldNames.end()) {
+                node->field = QueryField(it - fieldNames.begin());
+                pattern = token.substr(colon + 1);
+            }
+        }
+        if (pattern.empty())
+            throw std::invalid_argument("missing pattern in '" + token + "'");
+        node->matcher.emplace(pattern);
+        return node;
+    }
+
+    std::vector<std::string> tokens;
+    std::size_t position = 0;
+};
+
+}
+
+Query::Query(const std::string& text) : root(QueryParser(text).parse()) {}
+
+Query::~Query() = default;
+
+auto Query::run(const std::vector<PasswordData>& passwords) const -> std::vector<std::size_t> {
+    Columns columns;
+    for (auto& column : columns)
+        column.resize(passwords.size());
+    for (std::size_t i = 0; i < passwords.size(); ++i) {
+        columns[NAME][i] = &passwords[i].name;
+        columns[CATEGORY][i] = &passwords[i].category;
+        columns[WEBSITE][i] = passwords[i].website ? &passwords[i].website.value() : nullptr;
+        columns[LOGIN][i] = passwords[i].login ? &passwords[i].login.value() : nullptr;
+    }
+
+    std::size_t threadCount = passwords.size() < parallelThreshold ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Rows> partial(threadCount);
+    auto chunk = (passwords.size() + threadCount - 1) / threadCount;
+    auto evaluate = [&](std::size_t t) {
+        Rows rows(std::min(chunk * t + chunk, passwords.size()) - std::min(chunk * t, passwords.size()));
+        std::iota(rows.begin(), rows.end(), std::uint32_t(chunk * t));
+        partial[t] = root->select(columns, std::move(rows));
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < threadCount; ++t)
+        threads.emplace_back(evaluate, t);
+    evaluate(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<std::size_t> matches;
+    for (const Rows& part : partial)
+        matches.insert(matches.end(), part.begin(), part.end());
+    return matches;
+}
+
+auto findCommand(const std::vector<std::string>& args) -> void {
+    if (args.size() < 3)
+        throw std::runtime_error("usage: --find VAULT \"QUERY\"");
+    Query query(args[2]);
+    std::vector<PasswordData> passwords = loadVault(args[1], readPassword());
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::size_t> matches = query.run(passwords);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    for (auto i : matches) {
+        const PasswordData& p = passwords[i];
+        std::cout << p.name << '\t' << p.password << '\t' << p.category << '\t'
+                  << p.website.value_or("") << '\t' << p.login.value_or("") << '\n';
+    }
+    std::cerr << ">>> " << matches.size() << " of " << passwords.size() << " password(s) matched in "
+              << elapsed.count() << " ms.\n";
+
+    passwords.clear();
+    secretArena().wipe();
+}
@@ -0,0 +1,284 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include "header.hpp"
+
+struct RecordNode {
+    std::shared_ptr<const PasswordData> value;
+    std::shared_ptr<const RecordNode> left;
+    std::shared_ptr<const RecordNode> right;
+    std::size_t size;
+    int height;
+};
+
+namespace {
+
+using Link = std::shared_ptr<const RecordNode>;
+using Value = std::shared_ptr<const PasswordData>;
+
+auto sizeOf(const Link& node) -> std::size_t {
+    return node ? node->size : 0;
+}
+
+auto heightOf(const Link& node) -> int {
+    return node ? node->height : 0;
+}
+
+auto makeNode(Value value, Link left, Link right) -> Link {
+    auto size = sizeOf(left) + sizeOf(right) + 1;
+    auto height = std::max(heightOf(left), heightOf(right)) + 1;
+    return std::make_shared<const RecordNode>(RecordNode{std::move(value), std::move(left), std::move(right), size, height});
+}
+
+// Joins two subtrees whose heights differ by at most two, rotating once or twice if needed.
+auto balance(Value value, Link left, Link right) -> Link {
+    if (heightOf(left) > heightOf(right) + 1) {
+        if (heightOf(left->left) >= heightOf(left->right))
+            return makeNode(left->value, left->left, makeNode(std::move(value), left->right, std::move(right)));
+        const Link& middle = left->right;
+        return makeNode(middle->value, makeNode(left->value, left->left, middle->left),
+                        makeNode(std::move(value), middle->right, std::move(right)));
+    }
+    if (heightOf(right) > heightOf(left) + 1) {
+        if (heightOf(right->right) >= heightOf(right->left))
+            return makeNode(right->value, makeNode(std::move(value), std::move(left), right->left), right->right);
+        const Link& middle = right->left;
+        return makeNode(middle->value, makeNode(std::move(value), std::move(left), middle->left),
+                        makeNode(right->value, middle->right, right->right));
+    }
+    return makeNode(std::move(value), std::move(left), std::move(right));
+}
+
+auto build(const std::vector<Value>& values, std::size_t begin, std::size_t end) -> Link {
+    if (begin == end)
+        return nullptr;
+    auto middle = begin + (end - begin) / 2;
+    return makeNode(values[middle], build(values, begin, middle), build(values, middle + 1, end));
+}
+
+auto wrap(const std::vector<PasswordData>& passwords) -> std::vector<Value> {
+    std::vector<Value> values;
+    values.reserve(passwords.size());
+    for (const PasswordData& p : passwords)
+        values.push_back(std::make_shared<const PasswordData>(p));
+    return values;
+}
+
+auto collect(const Link& node, std::vector<Value>& values) -> void {
+    if (!node)
+        return;
+    collect(node->left, values);
+    values.push_back(node->value);
+    collect(node->right, values);
+}
+
+auto insertAt(const Link& node, std::size_t position, Value value) -> Link {
+    if (!node)
+        return makeNode(std::move(value), nullptr, nullptr);
+    auto leftSize = sizeOf(node->left);
+    if (position <= leftSize)
+        return balance(node->value, insertAt(node->left, position, std::move(value)), node->right);
+    return balance(node->value, node->left, insertAt(node->right, position - leftSize - 1, std::move(value)));
+}
+
+auto setAt(const Link& node, std::size_t position, Value value) -> Link {
+    auto leftSize = sizeOf(node->left);
+    if (position < leftSize)
+        return makeNode(node->value, setAt(node->left, position, std::move(value)), node->right);
+    if (position > leftSize)
+        return makeNode(node->value, node->left, setAt(node->right, position - leftSize - 1, std::move(value)));
+    return makeNode(std::move(value), node->left, node->right);
+}
+
+auto first(const Link& node) -> const Value& {
+    return node->left ? first(node->left) : node->value;
+}
+
+auto eraseAt(const Link& node, std::size_t position) -> Link {
+    auto leftSize = sizeOf(node->left);
+    if (position < leftSize)
+        return balance(node->value, eraseAt(node->left, position), node->right);
+    if (position > leftSize)
+        return balance(node->value, node->left, eraseAt(node->right, position - leftSize - 1));
+    if (!node->left)
+        return node->right;
+    if (!node->right)
+        return node->left;
+    return balance(first(node->right), node->left, eraseAt(node->right, 0));
+}
+
+}
+
+RecordList::RecordList(const std::vector<PasswordData>& passwords) : root(build(wrap(passwords), 0, passwords.size())) {}
+
+auto RecordList::size() const -> std::size_t {
+    return sizeOf(root);
+}
+
+auto RecordList::empty() const -> bool {
+    return !root;
+}
+
+auto RecordList::at(std::size_t position) const -> const PasswordData& {
+    if (position >= size())
+        throw std::out_of_range("record position out of range");
+    const RecordNode* node = root.get();
+    while (true) {
+        auto leftSize = sizeOf(node->left);
+        if (position == leftSize)
+            return *node->value;
+        if (position < leftSize) {
+            node = node->left.get();
+        } else {
+            position -= leftSize + 1;
+            node = node->right.get();
+        }
+    }
+}
+
+auto RecordList::insert(std::size_t position, const PasswordData& p) -> void {
+    if (position > size())
+        throw std::out_of_range("record position out of range");
+    root = insertAt(root, position, std::make_shared<const PasswordData>(p));
+}
+
+auto RecordList::pushBack(const PasswordData& p) -> void {
+    insert(size(), p);
+}
+
+auto RecordList::set(std::size_t position, const PasswordData& p) -> void {
+    if (position >= size())
+        throw std::out_of_range("record position out of range");
+    root = setAt(root, position, std::make_shared<const PasswordData>(p));
+}
+
+auto RecordList::erase(std::size_t position) -> void {
+    if (position >= size())
+        throw std::out_of_range("record position out of range");
+    root = eraseAt(root, position);
+}
+
+auto RecordList::reordered(const std::vector<std::uint32_t>& order) const -> RecordList {
+    if (order.size() != size())
+        throw std::invalid_argument("order does not match the number of records");
+    // An unchanged order keeps the same tree, so it does not count as a change.
+    if (std::ranges::is_sorted(order))
+        return *this;
+
+    std::vector<Value> values;
+    values.reserve(size());
+    collect(root, values);
+    std::vector<Value> permuted;
+    permuted.reserve(values.size());
+    for (auto i : order)
+        permuted.push_back(values.at(i));
+
+    RecordList list;
+    list.root = build(permuted, 0, permuted.size());
+    return list;
+}
+
+auto RecordList::changes(const RecordList& before, const std::function<void(const PasswordData&)>& onRemoved,
+                         const std::function<void(const PasswordData&)>& onAdded) const -> void {
+    // Both trees are walked from the tallest nodes down. A node found in both at the same height is a
+    // shared subtree and is skipped whole, so the work grows with the nodes the versions do not share.
+    using Entry = std::pair<int, const RecordNode*>;
+    std::priority_queue<Entry> older, newer;
+    if (before.root)
+        older.emplace(before.root->height, before.root.get());
+    if (root)
+        newer.emplace(root->height, root.get());
+
+    // Rebalancing moves records into new nodes, so a record counts only if it ends up on one side.
+    std::unordered_map<const PasswordData*, int> moved;
+    auto expand = [&](std::priority_queue<Entry>& queue, const RecordNode* node, int delta) {
+        moved[node->value.get()] += delta;
+        for (const Link& child : {node->left, node->right}) {
+            if (child)
+                queue.emplace(child->height, child.get());
+        }
+    };
+    while (!older.empty() || !newer.empty()) {
+        auto height = std::max(older.empty() ? 0 : older.top().first, newer.empty() ? 0 : newer.top().first);
+        std::vector<const RecordNode*> removed, added;
+        for (; !older.empty() && older.top().first == height; older.pop())
+            removed.push_back(older.top().second);
+        for (; !newer.empty() && newer.top().first == height; newer.pop())
+            added.push_back(newer.top().second);
+        std::ranges::sort(removed);
+        std::ranges::sort(added);
+        for (const RecordNode* node : removed) {
+            if (!std::ranges::binary_search(added, node))
+                expand(older, node, -1);
+        }
+        for (const RecordNode* node : added) {
+            if (!std::ranges::binary_search(removed, node))
+                expand(newer, node, 1);
+        }
+    }
+
+    for (const auto& [value, count] : moved) {
+        if (count < 0)
+            onRemoved(*value);
+    }
+    for (const auto& [value, count] : moved) {
+        if (count > 0)
+            onAdded(*value);
+    }
+}
+
+auto RecordList::identical(const RecordList& other) const -> bool {
+    return root == other.root;
+}
+
+auto RecordList::toVector() const -> std::vector<PasswordData> {
+    std::vector<PasswordData> passwords;
+    passwords.reserve(size());
+    for (const PasswordData& p : *this)
+        passwords.push_back(p);
+    return passwords;
+}
+
+auto RecordList::begin() const -> Iterator {
+    Iterator it;
+    it.descend(root.get());
+    return it;
+}
+
+auto RecordList::end() const -> Iterator {
+    return Iterator();
+}
+
+auto RecordList::Iterator::descend(const RecordNode* node) -> void {
+    for (; node; node = node->left.get())
+        path.push_back(node);
+}
+
+auto RecordList::Iterator::operator*() const -> const PasswordData& {
+    return *path.back()->value;
+}
+
+auto RecordList::Iterator::operator->() const -> const PasswordData* {
+    return path.back()->value.get();
+}
+
+auto RecordList::Iterator::operator++() -> Iterator& {
+    const RecordNode* node = path.back();
+    path.pop_back();
+    descend(node->right.get());
+    return *this;
+}
+
+auto RecordList::Iterator::operator++(int) -> Iterator {
+    Iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+auto RecordList::Iterator::operator==(const Iterator& other) const -> bool {
+    return path == other.path;
+}
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include "header.hpp"
+
+namespace {
+
+struct RekeyReport {
+    std::string file;
+    std::size_t records = 0;
+    double milliseconds = 0;
+    std::string error;
+};
+
+auto readKeyFile(const std::string& path) -> std::string {
+    std::ifstream input(path);
+    std::string key;
+    if (!input || !std::getline(input, key))
+        throw std::runtime_error("cannot read key from " + path);
+    if (key.ends_with('\r'))
+        key.pop_back();
+    if (key.empty())
+        throw std::runtime_error("empty key in " + path);
+    return key;
+}
+
+}
+
+auto rekeyVault(const std::string& file, const std::string& oldPassword, const std::string& newPassword) -> std::size_t {
+    VaultLock lock(file, VaultLock::EXCLUSIVE);
+    std::size_t records = 0;
+    std::string content;
+    if (!isFileEmpty(file)) {
+        {
+            // Without a tag, a wrong old key would go unnoticed and the garbage would be sealed for good.
+            std::ifstream stream(file);
+            if (stream.peek() != '[')
+                throw std::runtime_error("legacy XOR vault, open it once to upgrade it first");
+        }
+
+        VaultInfo info;
+        std::vector<PasswordData> passwords = readPipeline(file, oldPassword, nullptr, &info);
+        std::string header = newVaultHeader(info.generation + 1);
+        auto engine = makeCipherEngine(header, newPassword);
+        std::string secrets;
+        std::string data = serializePasswords(passwords, engine->recordKey(), &secrets);
+        // Every vault is written back the way it was read (or compressed when --compress was given).
+        if (info.compressed || settings().compress)
+            data = compressText(data);
+        content = encryptText(data, header, *engine, secrets) + "\n[TIMESTAMP] " + currentTimestamp();
+        records = passwords.size();
+    }
+
+    // A save appends to the history and the backup store under the same lock, so both are re-keyed
+    // before it is released. They are re-keyed into staged copies first: if one fails, nothing was
+    // replaced and the vault can be re-keyed again with the old password.
+    std::string error, history, backups;
+    try {
+        history = rekeyHistory(file, oldPassword, newPassword);
+    } catch (const std::exception& e) {
+        error = std::string("history not re-keyed: ") + e.what();
+    }
+    try {
+        backups = rekeyBackups(file, oldPassword, newPassword);
+    } catch (const std::exception& e) {
+        error += (error.empty() ? "" : "; ") + std::string("backups not re-keyed: ") + e.what();
+    }
+    if (!error.empty()) {
+        for (const std::string& staged : {history, backups}) {
+            if (!staged.empty())
+                std::filesystem::remove_all(staged);
+        }
+        throw std::runtime_error(error + "; the vault was left under the old password");
+    }
+
+    if (!content.empty())
+        fileModify(file, content);
+    replacePath(history, historyPath(file));
+    replacePath(backups, backupPath(file));
+    return records;
+}
+
+auto rekeyCommand(const std::vector<std::string>& args) -> int {
+    std::vector<std::string> files;
+    std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    for (auto i = 3; i < args.size(); ++i) {
+        if (args[i] == "--jobs" && i + 1 < args.size())
+            jobs = std::max(1, std::stoi(args[++i]));
+        else
+            files.push_back(args[i]);
+    }
+    if (files.empty())
+        throw std::runtime_error("usage: --rekey OLD_KEY_FILE NEW_KEY_FILE VAULT... [--jobs N]");
+
+    const std::string oldPassword = readKeyFile(args[1]);
+    const std::string newPassword = readKeyFile(args[2]);
+    jobs = std::min(jobs, files.size());
+
+    // Each worker holds one vault at a time, so memory stays bounded by the number of workers.
+    std::vector<RekeyReport> reports(files.size());
+    std::atomic<std::size_t> next = 0;
+    std::mutex output;
+    auto worker = [&] {
+        for (auto i = next++; i < files.size(); i = next++) {
+            RekeyReport& report = reports[i];
+            report.file = files[i];
+            auto start = std::chrono::steady_clock::now();
+            try {
+                report.records = rekeyVault(files[i], oldPassword, newPassword);
+            } catch (const std::exception& e) {
+                report.error = e.what();
+            }
+            report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> guard(output);
+            std::cout << (report.error.empty() ? "OK    " : "FAIL  ") << report.file << "  " << report.milliseconds << " ms";
+            if (report.error.empty())
+                std::cout << "  " << report.records << " password(s)";
+            else
+                std::cout << "  " << report.error;
+            std::cout << '\n';
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < jobs; ++t)
+        threads.emplace_back(worker);
+    for (auto& thread : threads)
+        thread.join();
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto failed = std::ranges::count_if(reports, [](const RekeyReport& r) { return !r.error.empty(); });
+    std::cout << ">>> Re-keyed " << files.size() - failed << " of " << files.size() << " vault(s) in " << elapsed
+              << " ms with " << jobs << " worker(s), " << failed << " failed.\n";
+
+    secretArena().wipe();
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "header.hpp"
+
+namespace {
+
+const std::string sealedMarker = "$s$";
+const std::string referenceMarker = "$r$";
+const std::string secretsTag = "[SECRETS] ";
+
+// Short strings would otherwise be stored inline in the PasswordData object, outside the arena.
+auto arenaString(std::string_view text) -> SecureString {
+    SecureString out;
+    out.reserve(std::max<std::size_t>(text.size(), 16));
+    out.assign(text);
+    return out;
+}
+
+}
+
+Secret::Secret(std::string_view plain) : data(arenaString(plain)) {}
+
+Secret::Secret(const Secret& other) : data(arenaString(other.data)), key(other.key) {}
+
+auto Secret::operator=(const Secret& other) -> Secret& {
+    if (this != &other) {
+        data = arenaString(other.data);
+        key = other.key;
+    }
+    return *this;
+}
+
+auto Secret::sealed(RecordKey key, std::string_view blob) -> Secret {
+    Secret secret;
+    secret.data = arenaString(blob);
+    secret.key = std::move(key);
+    return secret;
+}
+
+auto Secret::value() const -> SecureString {
+    return key ? openSecret(*key, data) : arenaString(data);
+}
+
+auto Secret::token(const std::string& recordKey, std::uint64_t counter) const -> std::string {
+    if (recordKey.empty())
+        return std::string(value());
+    return sealedMarker + toHex(sealSecret(recordKey, counter, value()));
+}
+
+auto Secret::fromToken(const std::string& token, const RecordKey& key, const SealedSecrets* secrets) -> Secret {
+    if (key && token.starts_with(sealedMarker))
+        return sealed(key, fromHex(token.substr(sealedMarker.size())));
+    if (key && token.starts_with(referenceMarker)) {
+        if (!secrets)
+            throw std::runtime_error("vault without its secrets section");
+        return sealed(key, secrets->blob(std::stoull(token.substr(referenceMarker.size()))));
+    }
+    return Secret(token);
+}
+
+auto SealedSecrets::blob(std::uint64_t number) const -> std::string_view {
+    if (number + 1 >= offsets.size())
+        throw std::runtime_error("secret " + std::to_string(number) + " missing from the secrets section");
+    std::string_view sealed = std::string_view(blobs).substr(offsets[number], offsets[number + 1] - offsets[number]);
+
+    // The nonce is authenticated with the secret, so checking that it holds the record number binds
+    // every blob to the record that refers to it.
+    std::string nonce(12, '\0');
+    for (auto i = 0; i < 8; ++i)
+        nonce[4 + i] = (char) (number >> (8 * i));
+    if (!sealed.starts_with(nonce))
+        throw std::runtime_error("secret " + std::to_string(number) + " does not belong to its record");
+    return sealed;
+}
+
+auto isSecretsSection(std::string_view line) -> bool {
+    return line.starts_with(secretsTag);
+}
+
+auto makeSecretsSection(std::string_view blobs, std::size_t count) -> std::string {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string line = secretsTag + "count=" + std::to_string(count) + " crc32c=";
+    auto crc = crc32c(blobs);
+    for (auto shift = 28; shift >= 0; shift -= 4)
+        line += digits[(crc >> shift) & 15];
+    line += ' ';
+    line += blobs;
+    return line;
+}
+
+auto parseSecretsSection(std::string_view line) -> SealedSecrets {
+    std::size_t count = 0;
+    std::uint32_t crc = 0;
+    std::string_view rest = line.substr(secretsTag.size());
+    for (auto field = 0; field < 2; ++field) {
+        auto end = std::min(rest.find(' '), rest.size());
+        std::string value(rest.substr(0, end));
+        if (value.starts_with("count="))
+            count = std::stoull(value.substr(6));
+        else if (value.starts_with("crc32c="))
+            crc = (std::uint32_t) std::stoul(value.substr(7), nullptr, 16);
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+    }
+    if (crc32c(rest) != crc)
+        throw std::runtime_error("vault damaged in its secrets section");
+
+    SealedSecrets secrets;
+    secrets.offsets.reserve(count + 1);
+    secrets.offsets.push_back(0);
+    for (std::size_t start = 0; start < rest.size();) {
+        auto end = std::min(rest.find(' ', start), rest.size());
+        secrets.offsets.push_back(secrets.offsets.back() + (end - start) / 2);
+        start = end + 1;
+    }
+    if (secrets.offsets.size() != count + 1)
+        throw std::runtime_error("vault damaged in its secrets section");
+    secrets.blobs = fromHex(std::string(rest));
+    return secrets;
+}
+
+auto wipeString(std::string& text) -> void {
+    volatile char* p = text.data();
+    for (auto i = 0; i < text.size(); ++i)
+        p[i] = 0;
+    text.clear();
+}
+
+auto wipeRecord(PasswordData& p) -> void {
+    wipeString(p.name);
+    wipeString(p.category);
+    if (p.website)
+        wipeString(p.website.value());
+    if (p.login)
+        wipeString(p.login.value());
+}
+
+auto operator==(const Secret& secret, std::string_view text) -> bool {
+    return std::string_view(secret.value()) == text;
+}
+
+auto operator<<(std::ostream& out, const Secret& secret) -> std::ostream& {
+    return out << secret.value();
+}
+
+auto operator>>(std::istream& in, Secret& secret) -> std::istream& {
+    std::string plain;
+    in >> plain;
+    secret = Secret(plain);
+    wipeString(plain);
+    return in;
+}
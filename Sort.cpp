@@ -0,0 +1,154 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include "header.hpp"
+
+namespace {
+
+constexpr std::size_t parallelSortThreshold = 1 << 16;
+
+// Sorts equal chunks on their own threads, then merges neighbouring runs pairwise, also in parallel.
+template<typename It, typename Compare>
+auto parallelSort(It first, It last, Compare comp) -> void {
+    std::size_t size = last - first;
+    std::size_t chunks = std::max(1u, std::thread::hardware_concurrency());
+    if (size < parallelSortThreshold || chunks < 2) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<std::size_t> bounds;
+    for (std::size_t c = 0; c <= chunks; ++c)
+        bounds.push_back(size * c / chunks);
+
+    std::vector<std::thread> threads;
+    for (std::size_t c = 0; c < chunks; ++c)
+        threads.emplace_back([=] { std::sort(first + bounds[c], first + bounds[c + 1], comp); });
+    for (auto& thread : threads)
+        thread.join();
+
+    for (std::size_t width = 1; width < chunks; width *= 2) {
+        threads.clear();
+        for (std::size_t c = 0; c + width < chunks; c += 2 * width) {
+            auto middle = bounds[c + width], end = bounds[std::min(c + 2 * width, chunks)];
+            threads.emplace_back([=] { std::inplace_merge(first + bounds[c], first + middle, first + end, comp); });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    }
+}
+
+template<SortField F>
+auto fieldValue(const PasswordData& p) -> const std::string* {
+    if constexpr (F == SortField::NAME)
+        return &p.name;
+    else if constexpr (F == SortField::CATEGORY)
+        return &p.category;
+    else if constexpr (F == SortField::WEBSITE)
+        return p.website ? &p.website.value() : nullptr;
+    else
+        return p.login ? &p.login.value() : nullptr;
+}
+
+// Replaces the values of one field by dense ranks that already include the direction and the place of
+// missing values, so the final multi-key sort only compares integers.
+template<SortField F>
+auto rankColumn(const std::vector<PasswordData>& passwords, const SortKey& key) -> std::vector<std::uint32_t> {
+    std::vector<std::uint32_t> present;
+    present.reserve(passwords.size());
+    for (std::uint32_t i = 0; i < passwords.size(); ++i) {
+        if (fieldValue<F>(passwords[i]))
+            present.push_back(i);
+    }
+    parallelSort(present.begin(), present.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return *fieldValue<F>(passwords[a]) < *fieldValue<F>(passwords[b]);
+    });
+
+    std::vector<std::uint32_t> ranks(passwords.size());
+    std::uint32_t rank = 0;
+    for (std::size_t i = 0; i < present.size(); ++i) {
+        if (i == 0 || *fieldValue<F>(passwords[present[i - 1]]) != *fieldValue<F>(passwords[present[i]]))
+            ++rank;
+        ranks[present[i]] = rank;
+    }
+    for (auto i : present)
+        ranks[i] = key.descending ? rank + 1 - ranks[i] : ranks[i];
+
+    auto missing = key.missingFirst ? 0 : rank + 1;
+    for (std::uint32_t i = 0; i < passwords.size(); ++i) {
+        if (!fieldValue<F>(passwords[i]))
+            ranks[i] = missing;
+    }
+    return ranks;
+}
+
+auto rankColumn(const std::vector<PasswordData>& passwords, const SortKey& key) -> std::vector<std::uint32_t> {
+    switch (key.field) {
+        case SortField::NAME:
+            return rankColumn<SortField::NAME>(passwords, key);
+        case SortField::CATEGORY:
+            return rankColumn<SortField::CATEGORY>(passwords, key);
+        case SortField::WEBSITE:
+            return rankColumn<SortField::WEBSITE>(passwords, key);
+        default:
+            return rankColumn<SortField::LOGIN>(passwords, key);
+    }
+}
+
+template<std::size_t N>
+struct SortRow {
+    std::array<std::uint32_t, N> ranks;
+    std::uint32_t index;
+};
+
+// The position is the last key, which keeps the sort stable.
+template<std::size_t N>
+auto sortedOrder(const std::vector<std::vector<std::uint32_t>>& columns, std::size_t size) -> std::vector<std::uint32_t> {
+    std::vector<SortRow<N>> rows(size);
+    for (std::uint32_t i = 0; i < size; ++i) {
+        for (std::size_t k = 0; k < N; ++k)
+            rows[i].ranks[k] = columns[k][i];
+        rows[i].index = i;
+    }
+    parallelSort(rows.begin(), rows.end(), [](const SortRow<N>& a, const SortRow<N>& b) {
+        return a.ranks != b.ranks ? a.ranks < b.ranks : a.index < b.index;
+    });
+
+    std::vector<std::uint32_t> order(size);
+    for (std::size_t i = 0; i < size; ++i)
+        order[i] = rows[i].index;
+    return order;
+}
+
+}
+
+auto sortOrder(const std::vector<PasswordData>& passwords, const std::vector<SortKey>& keys) -> std::vector<std::uint32_t> {
+    if (keys.empty() || keys.size() > sortFieldCount)
+        throw std::invalid_argument("between 1 and " + std::to_string(sortFieldCount) + " sort keys required");
+
+    std::vector<std::vector<std::uint32_t>> columns;
+    for (const SortKey& key : keys)
+        columns.push_back(rankColumn(passwords, key));
+
+    std::vector<std::uint32_t> order;
+    switch (keys.size()) {
+        case 1:
+            order = sortedOrder<1>(columns, passwords.size());
+            break;
+        case 2:
+            order = sortedOrder<2>(columns, passwords.size());
+            break;
+        case 3:
+            order = sortedOrder<3>(columns, passwords.size());
+            break;
+        default:
+            order = sortedOrder<4>(columns, passwords.size());
+    }
+    return order;
+}
@@ -0,0 +1,510 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <deque>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+#include "header.hpp"
+
+namespace {
+
+enum MatchPattern {
+    DICTIONARY,
+    SPATIAL,
+    REPEAT,
+    SEQUENCE,
+    DATE,
+    YEAR,
+    BRUTEFORCE
+};
+
+// One guessable part of a password, [i, j]. Guesses are kept as log10 so long passwords do not overflow.
+struct Match {
+    std::size_t i;
+    std::size_t j;
+    MatchPattern pattern;
+    double guesses;
+    WordList list = WordList::ENGLISH;
+    std::uint32_t rank = 0;
+    bool l33t = false;
+    bool reversed = false;
+    int turns = 0;
+    std::size_t baseLength = 0;
+};
+
+constexpr std::size_t maxEstimatedLength = 64;
+constexpr double minGuessesBeforeGrowingSequence = 4.0;
+constexpr int referenceYear = 2026;
+
+auto log10Sum(double a, double b) -> double {
+    auto high = std::max(a, b), low = std::min(a, b);
+    return high + std::log10(1 + std::pow(10.0, low - high));
+}
+
+auto log10Binomial(std::size_t n, std::size_t k) -> double {
+    return (std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0)) / std::log(10.0);
+}
+
+// log10 of sum_{i=1..min(a,b)} C(a+b, i): the ways to put back the variants of min(a,b) characters.
+auto log10Variations(std::size_t a, std::size_t b) -> double {
+    if (a == 0 || b == 0)
+        return std::log10(2.0);
+    auto total = -std::numeric_limits<double>::infinity();
+    for (std::size_t i = 1; i <= std::min(a, b); ++i)
+        total = log10Sum(total, log10Binomial(a + b, i));
+    return total;
+}
+
+auto uppercaseVariations(std::string_view token) -> double {
+    std::size_t upper = 0, lower = 0;
+    for (char c : token) {
+        upper += std::isupper((unsigned char) c) != 0;
+        lower += std::islower((unsigned char) c) != 0;
+    }
+    if (upper == 0)
+        return 0;
+    // Capitalized, all caps and a last capital letter are what people do first.
+    auto first = std::isupper((unsigned char) token.front()), last = std::isupper((unsigned char) token.back());
+    if (lower == 0 || (upper == 1 && (first || last)))
+        return std::log10(2.0);
+    return log10Variations(upper, lower);
+}
+
+const std::map<char, std::string_view> l33tTable = {
+    {'4', "a"}, {'@', "a"}, {'8', "b"}, {'(', "c"}, {'{', "c"}, {'[', "c"}, {'<', "c"}, {'3', "e"},
+    {'6', "g"}, {'9', "g"}, {'1', "il"}, {'!', "i"}, {'|', "il"}, {'7', "lt"}, {'0', "o"}, {'$', "s"},
+    {'5', "s"}, {'+', "t"}, {'%', "x"}, {'2', "z"}
+};
+
+// Walks the word graph from every position; l33t characters branch into the letters they stand for,
+// so no substituted variant of the password has to be generated.
+auto dictionaryMatches(std::string_view password, bool reversed, std::vector<Match>& matches) -> void {
+    const WordGraph& graph = wordGraph();
+    if (graph.empty())
+        return;
+    std::string folded(password);
+    std::ranges::transform(folded, folded.begin(), [](char c) { return (char) std::tolower((unsigned char) c); });
+
+    auto n = password.size();
+    auto add = [&](std::size_t i, std::size_t j, const WordEntry& entry, std::size_t substituted, std::size_t kept) {
+        Match match{i, j, DICTIONARY, 0};
+        match.list = entry.list;
+        match.rank = entry.rank;
+        match.l33t = substituted > 0;
+        match.reversed = reversed;
+        match.guesses = std::log10((double) entry.rank) + uppercaseVariations(password.substr(i, j - i + 1))
+                        + (substituted > 0 ? log10Variations(substituted, kept) : 0) + (reversed ? std::log10(2.0) : 0);
+        if (reversed)
+            match.i = n - 1 - j, match.j = n - 1 - i;
+        matches.push_back(match);
+    };
+
+    for (std::size_t i = 0; i < n; ++i) {
+        auto walk = [&](auto& self, WordGraph::Cursor cursor, std::size_t j, std::size_t substituted, std::size_t kept) -> void {
+            if (j > i)
+                if (auto entry = graph.word(cursor))
+                    add(i, j - 1, *entry, substituted, kept);
+            if (j == n)
+                return;
+            if (auto next = graph.next(cursor, folded[j]))
+                self(self, *next, j + 1, substituted, kept + std::isalpha((unsigned char) folded[j]));
+            if (auto it = l33tTable.find(folded[j]); it != l33tTable.end()) {
+                for (char letter : it->second) {
+                    if (auto next = graph.next(cursor, letter))
+                        self(self, *next, j + 1, substituted + 1, kept);
+                }
+            }
+        };
+        walk(walk, graph.start(), i, 0, 0);
+    }
+}
+
+// Keys of the slanted QWERTY layout, unshifted and shifted, by row and column.
+const std::array<std::string_view, 4> keyRows = {"`1234567890-=", " qwertyuiop[]\\", " asdfghjkl;'", " zxcvbnm,./"};
+const std::array<std::string_view, 4> shiftedRows = {"~!@#$%^&*()_+", " QWERTYUIOP{}|", " ASDFGHJKL:\"", " ZXCVBNM<>?"};
+
+struct KeyPosition {
+    int row = -1;
+    int column = -1;
+    bool shifted = false;
+};
+
+const auto keyPositions = [] {
+    std::array<KeyPosition, 256> positions{};
+    for (auto row = 0; row < 4; ++row) {
+        for (auto column = 0; column < keyRows[row].size(); ++column) {
+            if (keyRows[row][column] != ' ') {
+                positions[(unsigned char) keyRows[row][column]] = {row, column, false};
+                positions[(unsigned char) shiftedRows[row][column]] = {row, column, true};
+            }
+        }
+    }
+    return positions;
+}();
+
+// The direction from one key to a neighbouring one (0-5), or -1 if they are not neighbours.
+auto keyDirection(char from, char to) -> int {
+    const KeyPosition& a = keyPositions[(unsigned char) from];
+    const KeyPosition& b = keyPositions[(unsigned char) to];
+    if (a.row < 0 || b.row < 0)
+        return -1;
+    static constexpr std::array<std::pair<int, int>, 6> offsets = {{{0, -1}, {-1, 0}, {-1, 1}, {0, 1}, {1, 0}, {1, -1}}};
+    for (auto d = 0; d < offsets.size(); ++d) {
+        if (b.row - a.row == offsets[d].first && b.column - a.column == offsets[d].second)
+            return d;
+    }
+    return -1;
+}
+
+auto spatialMatches(std::string_view password, std::vector<Match>& matches) -> void {
+    constexpr double startingKeys = 47, averageDegree = 4.6;
+    std::size_t i = 0;
+    while (i + 2 < password.size()) {
+        auto j = i;
+        auto turns = 0, direction = -1;
+        std::size_t shifted = keyPositions[(unsigned char) password[i]].shifted;
+        while (j + 1 < password.size()) {
+            auto next = keyDirection(password[j], password[j + 1]);
+            if (next < 0)
+                break;
+            turns += next != direction;
+            direction = next;
+            shifted += keyPositions[(unsigned char) password[j + 1]].shifted;
+            ++j;
+        }
+
+        auto length = j - i + 1;
+        if (length >= 3) {
+            auto guesses = -std::numeric_limits<double>::infinity();
+            for (std::size_t l = 2; l <= length; ++l) {
+                for (std::size_t t = 1; t <= std::min<std::size_t>(turns, l - 1); ++t)
+                    guesses = log10Sum(guesses, log10Binomial(l - 1, t - 1) + std::log10(startingKeys)
+                                                    + t * std::log10(averageDegree));
+            }
+            if (shifted > 0)
+                guesses += shifted == length ? std::log10(2.0) : log10Variations(shifted, length - shifted);
+            Match match{i, j, SPATIAL, guesses};
+            match.turns = turns;
+            matches.push_back(match);
+        }
+        i = std::max(j, i + 1);
+    }
+}
+
+auto sequenceMatches(std::string_view password, std::vector<Match>& matches) -> void {
+    auto sameClass = [](char a, char b) {
+        return (std::islower((unsigned char) a) && std::islower((unsigned char) b))
+               || (std::isupper((unsigned char) a) && std::isupper((unsigned char) b))
+               || (std::isdigit((unsigned char) a) && std::isdigit((unsigned char) b));
+    };
+
+    std::size_t i = 0;
+    while (i + 2 < password.size()) {
+        auto delta = password[i + 1] - password[i];
+        auto j = i + 1;
+        if ((delta == 1 || delta == -1) && sameClass(password[i], password[i + 1])) {
+            while (j + 1 < password.size() && password[j + 1] - password[j] == delta && sameClass(password[j], password[j + 1]))
+                ++j;
+        }
+        if (j - i + 1 >= 3) {
+            char first = password[i];
+            double base = std::string_view("aAzZ019").find(first) != std::string_view::npos ? 4
+                          : std::isdigit((unsigned char) first) ? 10 : 26;
+            matches.push_back(Match{i, j, SEQUENCE, std::log10(base * (j - i + 1) * (delta < 0 ? 2 : 1))});
+            i = j + 1;
+        } else {
+            ++i;
+        }
+    }
+}
+
+auto repeatMatches(std::string_view password, std::vector<Match>& matches) -> void {
+    std::size_t i = 0;
+    while (i + 1 < password.size()) {
+        std::size_t bestLength = 0, bestBase = 0;
+        for (std::size_t base = 1; i + 2 * base <= password.size(); ++base) {
+            auto end = i + base;
+            while (end + base <= password.size() && password.compare(end, base, password.substr(i, base)) == 0)
+                end += base;
+            if (end - i > base && end - i > bestLength) {
+                bestLength = end - i;
+                bestBase = base;
+            }
+        }
+        if (bestLength == 0) {
+            ++i;
+            continue;
+        }
+
+        StrengthEstimate base = estimateStrength(password.substr(i, bestBase));
+        Match match{i, i + bestLength - 1, REPEAT, base.guessesLog10 + std::log10((double) bestLength / bestBase)};
+        match.baseLength = bestBase;
+        matches.push_back(match);
+        i += bestLength;
+    }
+}
+
+auto dateMatches(std::string_view password, std::vector<Match>& matches) -> void {
+    auto validDate = [](int day, int month, int year) {
+        return day >= 1 && day <= 31 && month >= 1 && month <= 12 && year >= 1000 && year <= 2099;
+    };
+    auto fullYear = [](int year, std::size_t digits) {
+        return digits == 2 ? (year > 50 ? 1900 + year : 2000 + year) : year;
+    };
+    auto dateGuesses = [](int year, bool separated) {
+        return std::log10(365.0 * std::max(std::abs(year - referenceYear), 20) * (separated ? 4 : 1));
+    };
+
+    auto n = password.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t length = 4; length <= 10 && i + length <= n; ++length) {
+            std::string_view token = password.substr(i, length);
+            auto digitsOnly = std::ranges::all_of(token, [](char c) { return std::isdigit((unsigned char) c); });
+
+            if (digitsOnly && length == 4) {
+                auto year = std::stoi(std::string(token));
+                if (year >= 1900 && year <= 2099)
+                    matches.push_back(Match{i, i + 3, YEAR, std::log10((double) std::max(std::abs(year - referenceYear), 20))});
+            }
+
+            // Split into three numbers, either by a repeated separator or, for plain digits, in every way.
+            std::vector<std::array<std::string_view, 3>> splits;
+            if (digitsOnly && length <= 8) {
+                for (std::size_t a = 1; a <= 4 && a < length; ++a) {
+                    for (std::size_t b = 1; b <= 2 && a + b < length; ++b)
+                        splits.push_back({token.substr(0, a), token.substr(a, b), token.substr(a + b)});
+                }
+            } else if (!digitsOnly) {
+                auto first = token.find_first_not_of("0123456789");
+                auto second = first == std::string_view::npos ? first : token.find_first_not_of("0123456789", first + 1);
+                if (first != std::string_view::npos && second != std::string_view::npos && token[first] == token[second]
+                    && std::string_view(" -/\\_.").find(token[first]) != std::string_view::npos
+                    && token.find_first_not_of("0123456789", second + 1) == std::string_view::npos && first > 0
+                    && second > first + 1 && second + 1 < length)
+                    splits.push_back({token.substr(0, first), token.substr(first + 1, second - first - 1), token.substr(second + 1)});
+            }
+
+            for (const auto& parts : splits) {
+                if (parts[0].size() > 4 || parts[1].size() > 2 || parts[2].size() > 4)
+                    continue;
+                int a = std::stoi(std::string(parts[0])), b = std::stoi(std::string(parts[1])), c = std::stoi(std::string(parts[2]));
+                auto found = false;
+                // Year last (day-month or month-day), then year first.
+                if (parts[2].size() == 2 || parts[2].size() == 4) {
+                    auto year = fullYear(c, parts[2].size());
+                    found = parts[0].size() <= 2 && (validDate(a, b, year) || validDate(b, a, year));
+                    if (found)
+                        matches.push_back(Match{i, i + length - 1, DATE, dateGuesses(year, !digitsOnly)});
+                }
+                if (!found && (parts[0].size() == 2 || parts[0].size() == 4) && parts[2].size() <= 2) {
+                    auto year = fullYear(a, parts[0].size());
+                    if (validDate(c, b, year) || validDate(b, c, year))
+                        matches.push_back(Match{i, i + length - 1, DATE, dateGuesses(year, !digitsOnly)});
+                }
+                if (found)
+                    break;
+            }
+        }
+    }
+}
+
+auto minimumGuesses(const Match& match) -> double {
+    return match.j == match.i ? 1 : std::log10(50.0);
+}
+
+// Finds the sequence of non-overlapping matches (gaps filled by brute force) that is guessed first,
+// minimising l! * product(guesses) + 10000^(l - 1) over the number of matches l.
+auto mostGuessable(std::string_view password, std::vector<Match>& matches, std::vector<Match>& sequence) -> double {
+    auto n = password.size();
+    if (n == 0)
+        return 0;
+
+    std::vector<std::vector<const Match*>> endingAt(n);
+    for (const Match& match : matches)
+        endingAt[match.j].push_back(&match);
+
+    constexpr double infinity = std::numeric_limits<double>::infinity();
+    // best[k * width + l]: smallest log10 product covering password[0..k] with l matches; back holds the
+    // last match. longest[k] is the largest l reached at k, so no row is scanned past it.
+    auto width = n + 1;
+    std::vector<double> best(n * width, infinity);
+    std::vector<const Match*> back(n * width, nullptr);
+    std::vector<std::size_t> longest(n, 0);
+    std::deque<Match> bruteforce;
+
+    auto update = [&](const Match& match, std::size_t l, double total) {
+        auto slot = match.j * width + l;
+        if (total < best[slot]) {
+            best[slot] = total;
+            back[slot] = &match;
+            longest[match.j] = std::max(longest[match.j], l);
+        }
+    };
+    auto consider = [&](const Match& match) {
+        auto guesses = std::max(match.guesses, minimumGuesses(match));
+        if (match.i == 0) {
+            update(match, 1, guesses);
+            return;
+        }
+        auto row = (match.i - 1) * width;
+        for (std::size_t l = 1; l <= longest[match.i - 1]; ++l) {
+            if (best[row + l] != infinity)
+                update(match, l + 1, best[row + l] + guesses);
+        }
+    };
+
+    for (std::size_t k = 0; k < n; ++k) {
+        for (const Match* match : endingAt[k])
+            consider(*match);
+        // Two brute force runs side by side never beat the one run covering both, so a run starts at
+        // the beginning or right after a pattern match; that keeps this loop from being cubic.
+        consider(bruteforce.emplace_back(Match{0, k, BRUTEFORCE, (double) (k + 1)}));
+        for (std::size_t i = 1; i <= k; ++i) {
+            auto row = (i - 1) * width;
+            const Match* run = nullptr;
+            for (std::size_t l = 1; l <= longest[i - 1]; ++l) {
+                if (!back[row + l] || back[row + l]->pattern == BRUTEFORCE)
+                    continue;
+                if (!run)
+                    run = &bruteforce.emplace_back(Match{i, k, BRUTEFORCE, (double) (k - i + 1)});
+                update(*run, l + 1, best[row + l] + std::max(run->guesses, minimumGuesses(*run)));
+            }
+        }
+    }
+
+    auto guesses = infinity;
+    std::size_t length = 0;
+    auto last = (n - 1) * width;
+    for (std::size_t l = 1; l <= longest[n - 1]; ++l) {
+        if (best[last + l] == infinity)
+            continue;
+        auto total = log10Sum(std::lgamma(l + 1.0) / std::log(10.0) + best[last + l], minGuessesBeforeGrowingSequence * (l - 1));
+        if (total < guesses) {
+            guesses = total;
+            length = l;
+        }
+    }
+
+    for (auto k = n - 1, l = length; l > 0; --l) {
+        const Match& match = *back[k * width + l];
+        sequence.push_back(match);
+        if (match.i == 0)
+            break;
+        k = match.i - 1;
+    }
+    std::ranges::reverse(sequence);
+    return guesses;
+}
+
+auto scoreOf(double guessesLog10) -> int {
+    constexpr std::array<double, 4> thresholds = {3, 6, 8, 10};
+    auto score = 0;
+    while (score < 4 && guessesLog10 >= thresholds[score])
+        ++score;
+    return score;
+}
+
+auto warningFor(const Match& match, bool alone) -> std::string {
+    switch (match.pattern) {
+        case DICTIONARY:
+            if (match.list == WordList::PASSWORDS) {
+                if (!alone || match.l33t || match.reversed)
+                    return "This is similar to a commonly used password";
+                return match.rank <= 10 ? "This is a top-10 common password"
+                       : match.rank <= 100 ? "This is a top-100 common password" : "This is a very common password";
+            }
+            if (match.list == WordList::NAMES)
+                return alone ? "Names and surnames by themselves are easy to guess" : "Common names and surnames are easy to guess";
+            return alone ? "A word by itself is easy to guess" : "Words in the dictionary are easy to guess";
+        case SPATIAL:
+            return match.turns == 1 ? "Straight rows of keys are easy to guess" : "Short keyboard patterns are easy to guess";
+        case REPEAT:
+            return match.baseLength == 1 ? "Repeats like \"aaa\" are easy to guess"
+                                         : "Repeats like \"abcabcabc\" are only slightly harder to guess than \"abc\"";
+        case SEQUENCE:
+            return "Sequences like abc or 6543 are easy to guess";
+        case DATE:
+            return "Dates are often easy to guess";
+        case YEAR:
+            return "Recent years are easy to guess";
+        default:
+            return "";
+    }
+}
+
+}
+
+auto estimateStrength(std::string_view password) -> StrengthEstimate {
+    StrengthEstimate estimate;
+    std::string_view estimated = password.substr(0, maxEstimatedLength);
+
+    std::vector<Match> matches;
+    dictionaryMatches(estimated, false, matches);
+    std::string reversed(estimated.rbegin(), estimated.rend());
+    dictionaryMatches(reversed, true, matches);
+    spatialMatches(estimated, matches);
+    sequenceMatches(estimated, matches);
+    repeatMatches(estimated, matches);
+    dateMatches(estimated, matches);
+
+    std::vector<Match> sequence;
+    // Characters past the estimated prefix count as brute force.
+    estimate.guessesLog10 = mostGuessable(estimated, matches, sequence) + (double) (password.size() - estimated.size());
+    estimate.score = scoreOf(estimate.guessesLog10);
+
+    if (estimate.score <= 2) {
+        auto longest = std::ranges::max_element(sequence, {}, [](const Match& m) {
+            return m.pattern == BRUTEFORCE ? 0 : m.j - m.i + 1;
+        });
+        if (longest != sequence.end())
+            estimate.warning = warningFor(*longest, sequence.size() == 1);
+    }
+    return estimate;
+}
+
+auto auditCommand(const std::vector<std::string>& args) -> int {
+    if (args.size() < 2)
+        throw std::runtime_error("usage: --audit VAULT");
+    std::vector<PasswordData> passwords = loadVault(args[1], readPassword());
+    wordGraph();
+
+    // Every thread estimates its own slice; the plain passwords only live for one estimate.
+    std::vector<StrengthEstimate> estimates(passwords.size());
+    auto threadCount = std::max<std::size_t>(1, std::min<std::size_t>(std::thread::hardware_concurrency(), passwords.size() / 1000 + 1));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            for (auto i = t; i < passwords.size(); i += threadCount) {
+                SecureString plain = passwords[i].password.value();
+                estimates[i] = estimateStrength(plain);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::array<std::size_t, 5> scores{};
+    for (std::size_t i = 0; i < passwords.size(); ++i) {
+        ++scores[estimates[i].score];
+        if (estimates[i].score < 3)
+            std::cout << "WEAK  " << passwords[i].name << "  score " << estimates[i].score << "/4"
+                      << (estimates[i].warning.empty() ? "" : "  " + estimates[i].warning) << '\n';
+    }
+    std::cout << ">>> Scores 0-4: " << scores[0] << " / " << scores[1] << " / " << scores[2] << " / " << scores[3] << " / "
+              << scores[4] << " of " << passwords.size() << " password(s), "
+              << (passwords.empty() ? 0 : elapsed * threadCount / passwords.size()) << " us per password.\n";
+
+    passwords.clear();
+    secretArena().wipe();
+    return scores[0] + scores[1] + scores[2] == 0 ? 0 : 1;
+}
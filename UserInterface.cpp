@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <ranges>
 #include <set>
+#include <chrono>
+#include <iomanip>
 
 enum myChoice {
     DISPLAY_CONTENT = 1,
@@ -15,31 +17,117 @@ enum myChoice {
     DELETE_PASSWORD = 6,
     ADD_CATEGORY = 7,
     DELETE_CATEGORY = 8,
-    EXIT = 9
+    FIND_BY_WEBSITE = 9,
+    UNDO = 10,
+    REDO = 11,
+    EXIT = 12
 };
 
+// Snapshots are cheap (RecordList shares its nodes), so the limit only bounds what old versions keep alive.
+constexpr std::size_t undoLimit = 100;
+
+struct VaultState {
+    RecordList records;
+    std::set<std::string> categories;
+};
+
+auto printPassword(const PasswordData& pData) -> void {
+    std::cout << "-----------------------\n";
+    std::cout << "Name: " << pData.name << std::endl;
+    std::cout << "Password: " << pData.password << std::endl;
+    std::cout << "Category: " << pData.category << std::endl;
+    if (pData.website.has_value()) {
+        std::cout << "Website: " << pData.website.value() << std::endl;
+    } else {
+        std::cout << "Website: N/A" << std::endl;
+    }
+    if (pData.login.has_value()) {
+        std::cout << "Username: " << pData.login.value() << std::endl;
+    } else {
+        std::cout << "Username: N/A" << std::endl;
+    }
+}
+
 auto displayContent(const std::vector<PasswordData>& passwords) -> void {
     std::cout << '\n';
     for (const PasswordData &pData: passwords) {
-        std::cout << "-----------------------\n";
-        std::cout << "Name: " << pData.name << std::endl;
-        std::cout << "Password: " << pData.password << std::endl;
-        std::cout << "Category: " << pData.category << std::endl;
-        if (pData.website.has_value()) {
-            std::cout << "Website: " << pData.website.value() << std::endl;
-        } else {
-            std::cout << "Website: N/A" << std::endl;
-        }
-        if (pData.login.has_value()) {
-            std::cout << "Username: " << pData.login.value() << std::endl;
-        } else {
-            std::cout << "Username: N/A" << std::endl;
+        printPassword(pData);
+    }
+}
+
+auto fuzzySearchPasswords(const std::vector<PasswordData>& passwords) -> void {
+    std::string pattern, errorsStr;
+    auto maxErrors = -1;
+
+    std::cout << "\n>>> Enter the text to search for in names, websites and logins: ";
+    std::cin >> pattern;
+    while (maxErrors < 0) {
+        try {
+            std::cout << "Maximum number of typos: ";
+            std::cin >> errorsStr;
+            maxErrors = std::stoi(errorsStr);
+            if (maxErrors < 0)
+                std::cout << ">>> Number must not be negative.\n";
+        } catch (const std::exception& e) {
+            std::cout << ">>> Number required.\n";
         }
     }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<FuzzyMatch> matches = fuzzySearch(passwords, pattern, maxErrors);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    for (const FuzzyMatch& match : matches) {
+        printPassword(passwords[match.index]);
+        std::cout << "Typos: " << match.distance << std::endl;
+    }
+    if (matches.empty())
+        std::cout << "NO PASSWORDS FOUND.\n";
+    std::cout << ">>> Searched " << passwords.size() << " password(s) in " << elapsed.count() << " ms.\n";
+}
+
+auto queryPasswords(const std::vector<PasswordData>& passwords) -> void {
+    std::string text;
+    std::cout << "\n>>> Enter the query: ";
+    std::getline(std::cin >> std::ws, text);
+
+    try {
+        Query query(text);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::size_t> matches = query.run(passwords);
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+        for (auto i : matches)
+            printPassword(passwords[i]);
+        if (matches.empty())
+            std::cout << "NO PASSWORDS FOUND.\n";
+        std::cout << ">>> " << matches.size() << " of " << passwords.size() << " password(s) matched in "
+                  << elapsed.count() << " ms.\n";
+    } catch (const std::invalid_argument& e) {
+        std::cout << ">>> INVALID QUERY: " << e.what() << ".\n";
+    }
 }
 
 auto searchPasswords(const std::vector<PasswordData>& passwords) -> void {
     std::string name, category;
+    std::string choice;
+
+    std::cout << "\n>>> Select search mode [NUMBER]\n"
+              << "1. Exact NAME and CATEGORY\n"
+              << "2. Fuzzy search\n"
+              << "3. Query (e.g. category:work AND website:*github* AND NOT login:admin)\n";
+    while (choice != "1" && choice != "2" && choice != "3") {
+        std::cout << "Your choice: ";
+        std::cin >> choice;
+    }
+    if (choice == "2") {
+        fuzzySearchPasswords(passwords);
+        return;
+    }
+    if (choice == "3") {
+        queryPasswords(passwords);
+        return;
+    }
 
     std::cout << "\n>>> Search for specific passwords by entering NAME and CATEGORY: ";
     std::cin >> name >> category;
@@ -52,69 +140,74 @@ auto searchPasswords(const std::vector<PasswordData>& passwords) -> void {
     }
 
     for (const PasswordData &pData: matching) {
-        std::cout << "-----------------------\n";
-        std::cout << "Name: " << pData.name << std::endl;
-        std::cout << "Password: " << pData.password << std::endl;
-        std::cout << "Category: " << pData.category << std::endl;
-        if (pData.website.has_value()) {
-            std::cout << "Website: " << pData.website.value() << std::endl;
-        } else {
-            std::cout << "Website: N/A" << std::endl;
-        }
-        if (pData.login.has_value()) {
-            std::cout << "Username: " << pData.login.value() << std::endl;
-        } else {
-            std::cout << "Username: N/A" << std::endl;
-        }
+        printPassword(pData);
     }
     if (matching.empty())
         std::cout << "NO PASSWORDS FOUND.\n";
 }
 
 
-auto sortPasswords(std::vector<PasswordData>& passwords) -> void {
-    std::string input1;
-    std::string input2;
-    auto choice1 = int();
-    auto choice2 = int();
+auto findByWebsite(const WebsiteIndex& index) -> void {
+    std::string url;
+    std::cout << "\n>>> Enter the website or URL: ";
+    std::cin >> url;
+
+    std::vector<PasswordData> found = index.lookup(url);
+    for (const PasswordData& pData : found)
+        printPassword(pData);
+    if (found.empty())
+        std::cout << "NO PASSWORDS FOUND FOR " << normalizeHost(url) << ".\n";
+}
+
+auto sortPasswords(RecordList& records) -> void {
+    const std::vector<std::string> fieldNames = {"Name", "Category", "Website", "Login"};
+    std::vector<SortKey> keys;
+    std::string input;
 
-    std::cout << "\n>>> Select sorting parameter [NUMBER]\n"
-    << "1. Sort by Name\n"
-    << "2. Sort by Category\n";
+    std::cout << "\n>>> Select sorting parameters [NUMBER]\n";
+    for (auto i = 0; i < fieldNames.size(); ++i)
+        std::cout << i + 1 << ". Sort by " << fieldNames[i] << '\n';
+    std::cout << ">>> Enter the numbers in order of priority, with '-' for descending order (e.g. 2 -1), and 0 to finish.\n";
 
-    while ((choice1 == choice2) || (choice1 != 1 && choice1 != 2) || (choice2 != 1 && choice2 != 2)) {
+    while (keys.size() < fieldNames.size()) {
         try {
-            std::cout << "Enter first parameter number: ";
-            std::cin >> input1;
-            choice1 = std::stoi(input1);
-            std::cout << "Enter second parameter number: ";
-            std::cin >> input2;
-            choice2 = std::stoi(input2);
-
-            if (choice1 == choice2)
+            std::cout << "Parameter number: ";
+            std::cin >> input;
+            auto choice = std::stoi(input);
+            if (choice == 0 && !keys.empty())
+                break;
+
+            auto field = std::abs(choice);
+            if (field < 1 || field > fieldNames.size()) {
+                std::cout << ">>> Wrong parameter.\n";
+            } else if (std::ranges::any_of(keys, [&](const SortKey& key) { return key.field == SortField(field - 1); })) {
                 std::cout << ">>> Parameters must be different from each other\n";
-            else if ((choice1 != 1 && choice1 != 2) || (choice2 != 1 && choice2 != 2))
-                std::cout << ">>> Wrong parameters.\n";
+            } else {
+                keys.push_back(SortKey{SortField(field - 1), choice < 0});
+            }
         } catch (const std::exception& e) {
-            std::cout << ">>> Number [1-2] required.\n";
+            std::cout << ">>> Number [1-" << fieldNames.size() << "] required.\n";
         }
     }
 
-    std::ranges::sort(passwords.begin(), passwords.end(), [choice1, choice2](const PasswordData& p1, const PasswordData& p2) {
-        if (choice1 == 1 && choice2 == 2) {
-            if (p1.name != p2.name)
-                return p1.name < p2.name;
-            else
-                return p1.category < p2.category;
-        } else if (choice1 == 2 && choice2 == 1) {
-            if (p1.category != p2.category)
-                return p1.category < p2.category;
-            else
-                return p1.name < p2.name;
+    if (std::ranges::any_of(keys, [](const SortKey& key) { return key.field == SortField::WEBSITE || key.field == SortField::LOGIN; })) {
+        std::string yesNo;
+        std::cout << "Passwords without website and login first? (y/n): ";
+        std::cin >> yesNo;
+        while (yesNo != "y" && yesNo != "Y" && yesNo != "n" && yesNo != "N") {
+            std::cout << ">>> Please enter (y/n): ";
+            std::cin >> yesNo;
         }
-    });
+        for (SortKey& key : keys)
+            key.missingFirst = yesNo == "y" || yesNo == "Y";
+    }
 
-    displayContent(passwords);
+    auto start = std::chrono::steady_clock::now();
+    records = records.reordered(sortOrder(records.toVector(), keys));
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    displayContent(records.toVector());
+    std::cout << ">>> Sorted " << records.size() << " password(s) in " << elapsed.count() << " ms.\n";
 }
 
 auto isUppercase(const std::string& text) -> bool {
@@ -132,16 +225,31 @@ auto isSpecialChar(const std::string& text) -> bool {
 }
 
 auto isStrong(const std::string& password) -> bool {
-    return password.length() >= 8 && isUppercase(password) && isSpecialChar(password);
+    return estimateStrength(password).score >= 3;
+}
+
+namespace {
+
+auto reportStrength(std::string_view password) -> void {
+    StrengthEstimate estimate = estimateStrength(password);
+    std::cout << ">>> Strength: " << estimate.score << "/4 (about 10^" << std::fixed << std::setprecision(1)
+              << estimate.guessesLog10 << std::defaultfloat << std::setprecision(6) << " guesses)";
+    if (!estimate.warning.empty())
+        std::cout << ", " << estimate.warning;
+    std::cout << ".\n";
+    if (estimate.score < 3)
+        std::cout << ">>> The entered password is weak.\n";
 }
 
-auto isUsed(const std::vector<PasswordData>& passwords, const std::string& password) -> bool {
+}
+
+auto isUsed(const RecordList& passwords, const std::string& password) -> bool {
     return std::ranges::any_of(passwords, [&](const PasswordData& passwordData) {
         return passwordData.password == password;
     });
 }
 
-auto passwordGenerator(const std::vector<PasswordData>& passwords, auto& length, bool& uppercase, bool& specialChar) -> std::string {
+auto passwordGenerator(const RecordList& passwords, auto& length, bool& uppercase, bool& specialChar) -> std::string {
     std::string chars = "abcdefghijklmnopqrstuvwxyz0123456789";
     if (uppercase)
         chars += "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
@@ -156,22 +264,11 @@ auto passwordGenerator(const std::vector<PasswordData>& passwords, auto& length,
             auto index = (std::rand() >> 8) % chars.length();
             newPassword += chars[index];
         }
-    } while (!isStrong(newPassword) && isUsed(passwords, newPassword));
+    } while (!isStrong(newPassword) || isUsed(passwords, newPassword));
 
     return newPassword;
 }
 
-auto readEncryptWrite(const std::string& file) -> void {
-    std::ifstream fileInput(file);
-    std::stringstream buffer;
-    buffer << fileInput.rdbuf();
-    std::string text = buffer.str();
-    std::string encrypted = encryptText(text);
-
-    std::ofstream fileOutput(file);
-    fileOutput << encrypted;
-}
-
 auto isFileEmpty(const std::string& file) -> bool {
     std::ifstream fileInput(file);
     return fileInput.peek() == std::ifstream::traits_type::eof();
@@ -201,7 +298,7 @@ auto addCategory(std::set<std::string>& categories) -> void {
     }
 }
 
-auto addPassword(std::vector<PasswordData>& passwords, std::set<std::string>& categories) -> void {
+auto addPassword(RecordList& passwords, std::set<std::string>& categories, WebsiteIndex& index) -> void {
     std::string name, password, category;
     std::string websiteIn, loginIn;
     std::optional<std::string> website, login;
@@ -234,9 +331,7 @@ auto addPassword(std::vector<PasswordData>& passwords, std::set<std::string>& ca
             case 1:
                 std::cout << "Enter the password: ";
                 std::cin >> password;
-
-                if (!isStrong(password))
-                    std::cout << ">>> The entered password is weak.\n";
+                reportStrength(password);
 
                 if (isUsed(passwords, password))
                     std::cout << ">>> The entered password has been already used.\n";
@@ -322,18 +417,21 @@ auto addPassword(std::vector<PasswordData>& passwords, std::set<std::string>& ca
             passwordData.login = login.value();
         }
 
-        passwords.push_back(passwordData);
+        passwords.pushBack(passwordData);
+        index.insert(passwordData);
     }
 }
 
-auto editPassword(std::vector<PasswordData> &passwords, std::set<std::string>& categories) -> void {
+auto editPassword(RecordList &passwords, std::set<std::string>& categories, WebsiteIndex& index) -> void {
      std::string passwordName;
      std::cout << "\nEnter password name to edit: ";
      std::cin >> passwordName;
      std::string choiceStr;
 
-     for (auto &data: passwords) {
-         if (data.name == passwordName) {
+     std::size_t position = 0;
+     for (const auto &found: passwords) {
+         if (found.name == passwordName) {
+             PasswordData data = found;
              do {
                  std::cout << ">>> Editing password: " + data.name << '\n';
                  std::cout << "1. Change password name\n"
@@ -358,6 +456,7 @@ auto editPassword(std::vector<PasswordData> &passwords, std::set<std::string>& c
                  }
                  std::string newWebsite, newLogin;
                  std::string newPass;
+                 PasswordData before = data;
 
                  switch (choice) {
                      case 1 :
@@ -368,6 +467,7 @@ auto editPassword(std::vector<PasswordData> &passwords, std::set<std::string>& c
                      case 2:
                          std::cout << "Enter new password: ";
                          std::cin >> data.password;
+                         reportStrength(data.password.value());
                          std::cout << "Password updated.\n";
                          break;
                      case 3:
@@ -398,13 +498,33 @@ auto editPassword(std::vector<PasswordData> &passwords, std::set<std::string>& c
                      default:
                          std::cout << "COMMAND NOT FOUND\n";
                     }
+                 index.erase(before);
+                 index.insert(data);
+                 passwords.set(position, data);
              } while (true);
          }
+         ++position;
      }
      std::cout << "PASSWORD NOT FOUND\n";
 }
 
-auto deletePassword(std::vector<PasswordData> &passwords) -> void {
+auto eraseRecords(RecordList& passwords, WebsiteIndex& index, const std::function<bool(const PasswordData&)>& matches) -> void {
+    std::vector<std::size_t> positions;
+    std::size_t position = 0;
+    for (const PasswordData& p : passwords) {
+        if (matches(p))
+            positions.push_back(position);
+        ++position;
+    }
+
+    // From the back, so the positions still to be erased do not shift.
+    for (auto it = positions.rbegin(); it != positions.rend(); ++it) {
+        index.erase(passwords.at(*it));
+        passwords.erase(*it);
+    }
+}
+
+auto deletePassword(RecordList &passwords, WebsiteIndex& index) -> void {
     std::string passName;
     std::string yesNo;
     auto count = int();
@@ -442,17 +562,15 @@ auto deletePassword(std::vector<PasswordData> &passwords) -> void {
     }
 
     if (choice == "y" || choice == "Y") {
-        for (const auto &e: toDelete) {
-            passwords.erase(std::remove_if(passwords.begin(), passwords.end(), [&](const PasswordData &p) {
-                return p.name == e;
-            }), passwords.end());
-        }
+        eraseRecords(passwords, index, [&](const PasswordData &p) {
+            return std::ranges::find(toDelete, p.name) != toDelete.end();
+        });
         std::cout << "Removed " << count << " element(s)\n";
     } else
         std::cout << "Operation cancelled.\n";
 }
 
-auto deleteCategory(std::vector<PasswordData> &passwords, std::set<std::string> &categories) -> void {
+auto deleteCategory(RecordList &passwords, std::set<std::string> &categories, WebsiteIndex& index) -> void {
     std::vector<std::string> toDelete;
     std::string category;
 
@@ -464,57 +582,148 @@ auto deleteCategory(std::vector<PasswordData> &passwords, std::set<std::string>
     } else {
         categories.erase(category);
 
-        passwords.erase(std::remove_if(passwords.begin(), passwords.end(), [&](const PasswordData &p) {
+        eraseRecords(passwords, index, [&](const PasswordData &p) {
             return p.category == category;
-        }), passwords.end());
+        });
         std::cout << "Category successfully deleted.\n";
     }
 }
 
-auto secondLine(const std::string &file) -> std::string {
-    std::ifstream inputStr(file);
-    std::string second;
+auto serializePasswords(const std::vector<PasswordData> &passwords, const std::string &recordKey,
+                        std::string *secrets) -> std::string {
+    std::string data;
+    std::string blobs;
+    std::uint64_t counter = 0;
+    for (const auto &password: passwords) {
+        std::string token;
+        if (secrets && !recordKey.empty()) {
+            blobs += (counter > 0 ? " " : "") + toHex(sealSecret(recordKey, counter, password.password.value()));
+            token = "$r$" + std::to_string(counter++);
+        } else {
+            token = password.password.token(recordKey, counter++);
+        }
+        data += password.name + " " + token + " " + password.category;
+        if (password.website.has_value() && password.login.has_value())
+            data += " " + password.website.value() + " " + password.login.value();
+        data += '\n';
+    }
+    if (secrets && !recordKey.empty() && counter > 0)
+        *secrets = makeSecretsSection(blobs, counter);
+    return data;
+}
+
+namespace {
+
+// Replaces the vault; the caller holds the exclusive lock.
+auto writeVault(const std::vector<PasswordData> &passwords, const std::string &file, const std::string &password,
+                std::uint64_t generation) -> void {
+    // An empty vault keeps its header, so its generation and history go on like after any other save.
+    std::string header = newVaultHeader(generation);
+    auto engine = makeCipherEngine(header, password);
+    std::string secrets;
+    std::string data = serializePasswords(passwords, engine->recordKey(), &secrets);
+
+    if (settings().compress) {
+        auto start = std::chrono::steady_clock::now();
+        std::string compressed = compressText(data);
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << ">>> Compressed " << data.size() << " -> " << compressed.size() << " bytes ("
+                  << std::fixed << std::setprecision(2) << (double) data.size() / compressed.size() << "x, "
+                  << data.size() / 1e6 / std::max(seconds, 1e-9) << " MB/s).\n" << std::defaultfloat;
+        data = std::move(compressed);
+    }
+
+    std::cout << "Encrypting file...\n";
+    fileModify(file, encryptText(data, header, *engine, secrets) + "\n[TIMESTAMP] " + currentTimestamp());
+    std::cout << ">>> Passwords saved to file.\n";
+
+    std::string plain = serializePasswords(passwords);
+    try {
+        recordHistory(file, password, plain);
+    } catch (const std::exception& e) {
+        std::cout << ">>> Warning: could not update the history (" << e.what() << ").\n";
+    }
+    try {
+        backupVault(file, password, plain);
+    } catch (const std::exception& e) {
+        std::cout << ">>> Warning: could not update the backups (" << e.what() << ").\n";
+    }
+    wipeString(plain);
+}
 
-    std::getline(inputStr, second);
-    std::getline(inputStr, second);
-    return second;
 }
 
 auto passwordsSave(const std::vector<PasswordData> &passwords, const std::string &file) -> void {
-    std::string s = secondLine(file);
+    std::cout << "\n>>> Saving passwords.\n";
+    passwordsSave(passwords, file, readPassword());
+}
 
-    std::ofstream fileOutput(file, std::ios::trunc);
+auto passwordsSave(const std::vector<PasswordData> &passwords, const std::string &file, const std::string &password) -> void {
+    VaultLock lock(file, VaultLock::EXCLUSIVE);
+    writeVault(passwords, file, password, vaultGeneration(file) + 1);
+}
 
-    if (!passwords.empty()) {
-        for (const auto &password: passwords) {
-            fileOutput << password.name << " " << password.password << " " << password.category;
-            if (password.website.has_value() && password.login.has_value()) {
-                fileOutput << " " << password.website.value() << " " << password.login.value() << '\n';
-            } else
-                fileOutput << '\n';
-        }
-        fileOutput.close();
-        std::cout << "\n>>> Passwords saved to file.\n";
-        std::cout << "Encrypting file...\n";
-        readEncryptWrite(file);
-
-        std::ofstream output(file, std::ios::app);
-        output << "\n" << s;
-        output.close();
+auto commitPasswords(const std::vector<PasswordData> &base, std::uint64_t baseGeneration,
+                     std::vector<PasswordData> &passwords, const std::string &file) -> void {
+    std::cout << "\n>>> Saving passwords.\n";
+    commitPasswords(base, baseGeneration, passwords, file, readPassword());
+}
+
+auto commitPasswords(const std::vector<PasswordData> &base, std::uint64_t baseGeneration,
+                     std::vector<PasswordData> &passwords, const std::string &file, const std::string &password) -> void {
+    VaultLock lock(file, VaultLock::EXCLUSIVE);
+    auto generation = vaultGeneration(file);
+    if (generation != baseGeneration) {
+        // Another session saved since this one opened the vault: its changes are merged, not overwritten.
+        std::cout << ">>> " << file << " was saved by another session (version " << baseGeneration << " -> "
+                  << generation << "), merging the changes.\n";
+        std::vector<PasswordData> theirs;
+        if (!isFileEmpty(file))
+            theirs = readPipeline(file, password);
+
+        MergeResult result = mergeVaults(base, passwords, theirs, false);
+        for (const std::string &conflict: result.conflicts)
+            std::cout << "CONFLICT " << conflict << '\n';
+        std::cout << ">>> Merged " << result.fromOurs << " change(s) of this session with " << result.fromTheirs
+                  << " of the other, " << result.conflicts.size() << " conflict(s) kept from this session.\n";
+        passwords = std::move(result.merged);
     }
 
+    writeVault(passwords, file, password, generation + 1);
 }
 
-auto userInterface(const std::string &file, std::vector<PasswordData> &passwords) -> void {
+auto userInterface(const std::string &file, std::vector<PasswordData> &passwords, std::uint64_t generation) -> void {
     std::set<std::string> categories;
+    WebsiteIndex index;
     for (auto &el: passwords) {
         categories.insert(el.category);
+        index.insert(el);
     }
 
+    VaultState state{RecordList(passwords), categories};
+    const RecordList base = state.records;
+    std::vector<VaultState> undoStack, redoStack;
+    passwords.clear();
+
+    auto restore = [&](std::vector<VaultState>& from, std::vector<VaultState>& to, const std::string& action) {
+        if (from.empty()) {
+            std::cout << ">>> NOTHING TO " << action << ".\n";
+            return;
+        }
+        to.push_back(state);
+        state = from.back();
+        from.pop_back();
+        // Only the records that differ between the two snapshots are moved in the website index.
+        state.records.changes(to.back().records, [&](const PasswordData& p) { index.erase(p); },
+                              [&](const PasswordData& p) { index.insert(p); });
+        std::cout << ">>> " << action << " DONE (" << state.records.size() << " password(s)).\n";
+    };
+
     std::string input;
     auto choice = int();
     do {
         do {
+            VaultState before = state;
             try {
                 std::cout << "\n>>> Choose an option:\n"
                              "1. DISPLAY_CONTENT\n"
@@ -525,7 +734,10 @@ auto userInterface(const std::string &file, std::vector<PasswordData> &passwords
                              "6. DELETE_PASSWORD\n"
                              "7. ADD_CATEGORY\n"
                              "8. DELETE_CATEGORY\n"
-                             "9. EXIT\n";
+                             "9. FIND_BY_WEBSITE\n"
+                             "10. UNDO\n"
+                             "11. REDO\n"
+                             "12. EXIT\n";
 
 
                 std::cout << "Your choice: ";
@@ -535,31 +747,52 @@ auto userInterface(const std::string &file, std::vector<PasswordData> &passwords
 
                 switch (choice) {
                     case DISPLAY_CONTENT:
-                        displayContent(passwords);
+                        displayContent(state.records.toVector());
                         break;
                     case SEARCH_PASSWORDS:
-                        searchPasswords(passwords);
+                        searchPasswords(state.records.toVector());
                         break;
                     case SORT_PASSWORDS:
-                        sortPasswords(passwords);
+                        sortPasswords(state.records);
                         break;
                     case ADD_PASSWORD:
-                        addPassword(passwords, categories);
+                        addPassword(state.records, state.categories, index);
                         break;
                     case EDIT_PASSWORD:
-                        editPassword(passwords, categories);
+                        editPassword(state.records, state.categories, index);
                         break;
                     case DELETE_PASSWORD:
-                        deletePassword(passwords);
+                        deletePassword(state.records, index);
                         break;
                     case ADD_CATEGORY:
-                        addCategory(categories);
+                        addCategory(state.categories);
                         break;
                     case DELETE_CATEGORY:
-                        deleteCategory(passwords, categories);
+                        deleteCategory(state.records, state.categories, index);
+                        break;
+                    case FIND_BY_WEBSITE:
+                        findByWebsite(index);
+                        break;
+                    case UNDO:
+                        restore(undoStack, redoStack, "UNDO");
+                        before = state;
+                        break;
+                    case REDO:
+                        restore(redoStack, undoStack, "REDO");
+                        before = state;
                         break;
                     case EXIT:
-                        passwordsSave(passwords, file);
+                        passwords = state.records.toVector();
+                        if (state.records.identical(base) && generation > 0) {
+                            std::cout << ">>> No changes, the vault was left as it is.\n";
+                            return;
+                        }
+                        try {
+                            commitPasswords(base.toVector(), generation, passwords, file);
+                        } catch (const std::exception &e) {
+                            std::cout << ">>> The vault was not saved (" << e.what() << "). Choose EXIT to try again.\n";
+                            break;
+                        }
                         return;
                     default:
                         std::cout << ">>> COMMAND NOT FOUND.\n";
@@ -567,6 +800,14 @@ auto userInterface(const std::string &file, std::vector<PasswordData> &passwords
             } catch (const std::exception &e) {
                 std::cout << ">>> INVALID ARGUMENT (NUMBER REQUIRED).\n";
             }
-        } while (choice >= 1 && choice < 9);
+
+            // Every change made by an option, even one interrupted by an error, is one undo step.
+            if (!state.records.identical(before.records) || state.categories != before.categories) {
+                undoStack.push_back(std::move(before));
+                if (undoStack.size() > undoLimit)
+                    undoStack.erase(undoStack.begin());
+                redoStack.clear();
+            }
+        } while (choice >= 1 && choice < EXIT);
     } while (true);
-}
\ No newline at end of file
+}
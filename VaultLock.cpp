@@ -0,0 +1,68 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include "header.hpp"
+
+namespace {
+
+auto lockFile(int fd, int operation) -> int {
+    int result;
+    while ((result = flock(fd, operation)) != 0 && errno == EINTR) {}
+    return result;
+}
+
+}
+
+auto lockPath(const std::string& file) -> std::string {
+    return file + ".lock";
+}
+
+VaultLock::VaultLock(const std::string& file, Mode mode) {
+    fd = open(lockPath(file).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0 && mode == SHARED)
+        fd = open(lockPath(file).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        // Saves replace the vault atomically, so a reader that cannot lock still sees a whole version.
+        if (mode == SHARED)
+            return;
+        throw std::runtime_error("cannot create " + lockPath(file));
+    }
+
+    auto operation = mode == SHARED ? LOCK_SH : LOCK_EX;
+    if (lockFile(fd, operation | LOCK_NB) == 0)
+        return;
+    if (errno == EWOULDBLOCK) {
+        std::cout << ">>> " << file << " is " << (mode == SHARED ? "being saved" : "in use")
+                  << " by another session, waiting...\n";
+        if (lockFile(fd, operation) == 0)
+            return;
+    }
+    close(fd);
+    throw std::runtime_error("cannot lock " + file);
+}
+
+VaultLock::~VaultLock() {
+    if (fd >= 0)
+        close(fd);
+}
+
+auto vaultGeneration(const std::string& file) -> std::uint64_t {
+    std::ifstream stream(file, std::ios::binary);
+    std::string header;
+    if (stream.peek() != '[' || !std::getline(stream, header))
+        return 0;
+    return headerGeneration(header);
+}
+
+auto headerGeneration(std::string_view header) -> std::uint64_t {
+    const std::string_view field = " gen=";
+    auto found = header.find(field);
+    if (!header.starts_with(vaultHeaderTag) || found == std::string_view::npos)
+        return 0;
+    return std::stoull(std::string(header.substr(found + field.size())));
+}
@@ -0,0 +1,176 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <cctype>
+#include "header.hpp"
+
+namespace {
+
+// Suffixes under which every label belongs to a different owner, so "a.co.uk" must never match "b.co.uk".
+const std::unordered_set<std::string> multiLabelSuffixes = {
+    "co.uk", "org.uk", "ac.uk", "gov.uk", "me.uk", "ltd.uk", "plc.uk",
+    "com.au", "net.au", "org.au", "edu.au", "gov.au",
+    "co.jp", "ne.jp", "or.jp", "ac.jp",
+    "co.nz", "org.nz", "net.nz",
+    "com.br", "net.br", "org.br",
+    "com.pl", "net.pl", "org.pl", "edu.pl", "gov.pl",
+    "co.in", "net.in", "org.in",
+    "com.cn", "net.cn", "org.cn",
+    "com.mx", "com.tr", "co.za", "co.kr", "com.sg", "com.hk", "com.tw",
+    "github.io", "gitlab.io", "herokuapp.com", "blogspot.com", "appspot.com"
+};
+
+auto isAddress(const std::string& host) -> bool {
+    return host.find(':') != std::string::npos
+        || std::ranges::all_of(host, [](char c) { return std::isdigit((unsigned char) c) || c == '.'; });
+}
+
+// Labels from the top-level domain down; an IP address is kept whole.
+auto reversedLabels(const std::string& host) -> std::vector<std::string> {
+    if (isAddress(host))
+        return {host};
+
+    std::vector<std::string> labels;
+    std::size_t end = host.size();
+    while (end > 0) {
+        auto dot = host.rfind('.', end - 1);
+        auto begin = dot == std::string::npos ? 0 : dot + 1;
+        if (end > begin)
+            labels.push_back(host.substr(begin, end - begin));
+        if (dot == std::string::npos)
+            break;
+        end = dot;
+    }
+    return labels;
+}
+
+// Number of labels of the registrable domain ("example.co.uk" -> 3); parents above it are public suffixes.
+auto registrableDepth(const std::vector<std::string>& labels) -> std::size_t {
+    if (labels.size() >= 2 && multiLabelSuffixes.contains(labels[1] + '.' + labels[0]))
+        return std::min<std::size_t>(3, labels.size());
+    return std::min<std::size_t>(2, labels.size());
+}
+
+auto sameRecord(const PasswordData& a, const PasswordData& b) -> bool {
+    return a.name == b.name && a.category == b.category && a.login == b.login;
+}
+
+}
+
+auto normalizeHost(const std::string& url) -> std::string {
+    std::string host = url;
+
+    if (auto scheme = host.find("://"); scheme != std::string::npos)
+        host.erase(0, scheme + 3);
+    host = host.substr(0, host.find_first_of("/?#"));
+    if (auto at = host.rfind('@'); at != std::string::npos)
+        host.erase(0, at + 1);
+
+    if (host.starts_with('[')) {
+        host = host.substr(1, host.find(']') - 1);
+    } else if (auto colon = host.find(':'); colon != std::string::npos) {
+        host.erase(colon);
+    }
+
+    std::ranges::transform(host, host.begin(), [](unsigned char c) { return std::tolower(c); });
+    while (host.ends_with('.'))
+        host.pop_back();
+    if (host.starts_with("www.") && host.find('.', 4) != std::string::npos)
+        host.erase(0, 4);
+    return host;
+}
+
+auto WebsiteIndex::insert(const PasswordData& p) -> void {
+    if (!p.website.has_value())
+        return;
+    std::string host = normalizeHost(p.website.value());
+    if (host.empty())
+        return;
+
+    Node* node = &root;
+    for (const std::string& label : reversedLabels(host)) {
+        std::unique_ptr<Node>& child = node->children[label];
+        if (!child)
+            child = std::make_unique<Node>();
+        node = child.get();
+    }
+    node->entries.push_back(p);
+    ++count;
+}
+
+auto WebsiteIndex::erase(const PasswordData& p) -> void {
+    if (!p.website.has_value())
+        return;
+
+    std::vector<std::pair<Node*, std::string>> path;
+    Node* node = &root;
+    for (const std::string& label : reversedLabels(normalizeHost(p.website.value()))) {
+        auto it = node->children.find(label);
+        if (it == node->children.end())
+            return;
+        path.emplace_back(node, label);
+        node = it->second.get();
+    }
+
+    auto it = std::ranges::find_if(node->entries, [&](const PasswordData& entry) { return sameRecord(entry, p); });
+    if (it == node->entries.end())
+        return;
+    node->entries.erase(it);
+    --count;
+
+    // Drop the branch if nothing else hangs below it.
+    while (!path.empty() && node->entries.empty() && node->children.empty()) {
+        auto [parent, label] = path.back();
+        path.pop_back();
+        parent->children.erase(label);
+        node = parent;
+    }
+}
+
+auto WebsiteIndex::lookup(const std::string& url) const -> std::vector<PasswordData> {
+    std::vector<std::string> labels = reversedLabels(normalizeHost(url));
+    auto minimum = registrableDepth(labels);
+
+    std::vector<const Node*> matched;
+    const Node* node = &root;
+    for (std::size_t depth = 1; depth <= labels.size(); ++depth) {
+        auto it = node->children.find(labels[depth - 1]);
+        if (it == node->children.end())
+            break;
+        node = it->second.get();
+        if (depth >= minimum)
+            matched.push_back(node);
+    }
+
+    std::vector<PasswordData> found;
+    for (auto it = matched.rbegin(); it != matched.rend(); ++it)
+        found.insert(found.end(), (*it)->entries.begin(), (*it)->entries.end());
+    return found;
+}
+
+auto WebsiteIndex::clear() -> void {
+    // Labels are the hosts the records belong to, so they are wiped along with the copies.
+    std::vector<std::unique_ptr<Node>> pending;
+    auto wipe = [&](Node& node) {
+        for (PasswordData& entry : node.entries)
+            wipeRecord(entry);
+        while (!node.children.empty()) {
+            auto child = node.children.extract(node.children.begin());
+            wipeString(child.key());
+            pending.push_back(std::move(child.mapped()));
+        }
+    };
+    wipe(root);
+    while (!pending.empty()) {
+        std::unique_ptr<Node> node = std::move(pending.back());
+        pending.pop_back();
+        wipe(*node);
+    }
+    root = Node();
+    count = 0;
+}
+
+auto WebsiteIndex::size() const -> std::size_t {
+    return count;
+}
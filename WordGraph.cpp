@@ -0,0 +1,257 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "header.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char graphMagic[8] = {'P', 'M', 'W', 'O', 'R', 'D', 'S', '1'};
+
+// On-disk layout: GraphHeader, the nodes, the edges (grouped by node and sorted by label), then one
+// value per word in lexicographic order. Everything is read in place from the mapping.
+struct GraphHeader {
+    char magic[8];
+    std::uint32_t nodeCount;
+    std::uint32_t edgeCount;
+    std::uint32_t wordCount;
+    std::uint32_t root;
+};
+
+struct GraphNode {
+    std::uint32_t firstEdge;
+    std::uint32_t words;
+    std::uint16_t edgeCount;
+    std::uint16_t final;
+};
+
+struct GraphEdge {
+    std::uint32_t target;
+    // Words reachable through the earlier edges of the node, plus one if the node itself is a word.
+    std::uint32_t skip;
+    std::uint8_t label;
+    std::uint8_t padding[3];
+};
+
+struct TrieNode {
+    bool final = false;
+    std::map<unsigned char, std::unique_ptr<TrieNode>> children;
+    std::uint32_t id = 0;
+};
+
+// Merges equal subtrees bottom-up: two nodes are equal when they agree on being a word and have
+// the same labels leading to equal children.
+class Minimizer {
+public:
+    auto canonical(TrieNode& node) -> std::uint32_t {
+        std::string signature(1, node.final ? '1' : '0');
+        for (auto& [label, child] : node.children) {
+            auto id = canonical(*child);
+            signature += label;
+            signature.append(reinterpret_cast<const char*>(&id), sizeof id);
+        }
+
+        auto [it, inserted] = registry.emplace(signature, (std::uint32_t) nodes.size());
+        if (inserted) {
+            GraphNode graphNode{(std::uint32_t) edges.size(), node.final ? 1u : 0u, (std::uint16_t) node.children.size(),
+                                (std::uint16_t) node.final};
+            std::uint32_t skip = node.final ? 1 : 0;
+            for (auto& [label, child] : node.children) {
+                edges.push_back(GraphEdge{child->id, skip, (std::uint8_t) label, {}});
+                skip += nodes[child->id].words;
+            }
+            graphNode.words = skip;
+            nodes.push_back(graphNode);
+        }
+        node.id = it->second;
+        return node.id;
+    }
+
+    std::vector<GraphNode> nodes;
+    std::vector<GraphEdge> edges;
+
+private:
+    std::map<std::string, std::uint32_t> registry;
+};
+
+auto defaultGraphPath() -> std::string {
+    if (const char* path = std::getenv("PM_WORD_GRAPH"); path && *path)
+        return path;
+    char exe[PATH_MAX];
+    auto length = readlink("/proc/self/exe", exe, sizeof exe - 1);
+    if (length <= 0)
+        return "words.graph";
+    return (fs::path(std::string(exe, length)).parent_path() / "words.graph").string();
+}
+
+}
+
+auto buildWordGraph(const std::vector<std::string>& lists, const std::string& output) -> std::size_t {
+    std::map<std::string, std::uint32_t> words;
+    for (std::uint32_t list = 0; list < lists.size(); ++list) {
+        std::ifstream input(lists[list]);
+        if (!input)
+            throw std::runtime_error("cannot open " + lists[list]);
+        std::uint32_t rank = 0;
+        std::string line;
+        while (std::getline(input, line)) {
+            std::erase_if(line, [](char c) { return std::isspace((unsigned char) c); });
+            if (line.empty() || line.starts_with('#'))
+                continue;
+            std::ranges::transform(line, line.begin(), [](char c) { return (char) std::tolower((unsigned char) c); });
+            auto value = list << wordListShift | ++rank;
+            // A word listed more than once keeps its best rank.
+            if (auto [it, inserted] = words.emplace(line, value); !inserted && (value & wordRankMask) < (it->second & wordRankMask))
+                it->second = value;
+        }
+    }
+
+    TrieNode root;
+    for (const auto& [word, value] : words) {
+        TrieNode* node = &root;
+        for (char c : word) {
+            auto& child = node->children[(unsigned char) c];
+            if (!child)
+                child = std::make_unique<TrieNode>();
+            node = child.get();
+        }
+        node->final = true;
+    }
+
+    Minimizer minimizer;
+    GraphHeader header{};
+    std::memcpy(header.magic, graphMagic, sizeof graphMagic);
+    header.root = minimizer.canonical(root);
+    header.nodeCount = minimizer.nodes.size();
+    header.edgeCount = minimizer.edges.size();
+    header.wordCount = words.size();
+
+    std::string data(reinterpret_cast<const char*>(&header), sizeof header);
+    data.append(reinterpret_cast<const char*>(minimizer.nodes.data()), minimizer.nodes.size() * sizeof(GraphNode));
+    data.append(reinterpret_cast<const char*>(minimizer.edges.data()), minimizer.edges.size() * sizeof(GraphEdge));
+    for (const auto& [word, value] : words)
+        data.append(reinterpret_cast<const char*>(&value), sizeof value);
+    fileModify(output, data);
+
+    std::cout << ">>> Word graph: " << words.size() << " word(s), " << minimizer.nodes.size() << " node(s), "
+              << minimizer.edges.size() << " edge(s), " << data.size() << " bytes.\n";
+    return words.size();
+}
+
+WordGraph::WordGraph(const std::string& file) {
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t) sizeof(GraphHeader)) {
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            base = mapped;
+            mappedSize = info.st_size;
+        }
+    }
+    close(fd);
+    if (!base)
+        return;
+
+    auto header = static_cast<const GraphHeader*>(base);
+    auto expected = sizeof(GraphHeader) + std::size_t(header->nodeCount) * sizeof(GraphNode)
+                    + std::size_t(header->edgeCount) * sizeof(GraphEdge) + std::size_t(header->wordCount) * sizeof(std::uint32_t);
+    auto graphNodes = reinterpret_cast<const GraphNode*>(header + 1);
+    auto graphEdges = reinterpret_cast<const GraphEdge*>(graphNodes + header->nodeCount);
+    // Lookups follow the offsets without checks, so every one of them is checked here once.
+    auto valid = std::memcmp(header->magic, graphMagic, sizeof graphMagic) == 0 && expected == mappedSize
+                 && header->root < header->nodeCount;
+    for (std::uint32_t i = 0; valid && i < header->nodeCount; ++i)
+        valid = std::uint64_t(graphNodes[i].firstEdge) + graphNodes[i].edgeCount <= header->edgeCount;
+    for (std::uint32_t i = 0; valid && i < header->edgeCount; ++i)
+        valid = graphEdges[i].target < header->nodeCount;
+    if (!valid) {
+        munmap(base, mappedSize);
+        base = nullptr;
+        return;
+    }
+    nodes = reinterpret_cast<const char*>(graphNodes);
+    edges = reinterpret_cast<const char*>(graphEdges);
+    values = reinterpret_cast<const std::uint32_t*>(graphEdges + header->edgeCount);
+    rootNode = header->root;
+    wordCount = header->wordCount;
+}
+
+WordGraph::~WordGraph() {
+    if (base)
+        munmap(base, mappedSize);
+}
+
+auto WordGraph::empty() const -> bool {
+    return wordCount == 0;
+}
+
+auto WordGraph::size() const -> std::size_t {
+    return wordCount;
+}
+
+auto WordGraph::start() const -> Cursor {
+    return Cursor{rootNode, 0};
+}
+
+auto WordGraph::next(Cursor cursor, char c) const -> std::optional<Cursor> {
+    if (empty())
+        return std::nullopt;
+    auto node = reinterpret_cast<const GraphNode*>(nodes) + cursor.node;
+    auto first = reinterpret_cast<const GraphEdge*>(edges) + node->firstEdge;
+    for (auto edge = first; edge != first + node->edgeCount; ++edge) {
+        if (edge->label == (std::uint8_t) c)
+            return Cursor{edge->target, cursor.index + edge->skip};
+        if (edge->label > (std::uint8_t) c)
+            break;
+    }
+    return std::nullopt;
+}
+
+auto WordGraph::word(Cursor cursor) const -> std::optional<WordEntry> {
+    // A damaged skip count could point past the values, which the load cannot rule out cheaply.
+    if (empty() || !reinterpret_cast<const GraphNode*>(nodes)[cursor.node].final || cursor.index >= wordCount)
+        return std::nullopt;
+    auto value = values[cursor.index];
+    return WordEntry{WordList(value >> wordListShift), value & wordRankMask};
+}
+
+auto WordGraph::find(std::string_view text) const -> std::optional<WordEntry> {
+    Cursor cursor = start();
+    for (char c : text) {
+        auto next = this->next(cursor, c);
+        if (!next)
+            return std::nullopt;
+        cursor = *next;
+    }
+    return word(cursor);
+}
+
+auto wordGraph() -> const WordGraph& {
+    static const WordGraph graph(defaultGraphPath());
+    static const bool warned = [] {
+        if (graph.empty())
+            std::cout << ">>> Warning: no word graph at " << defaultGraphPath()
+                      << ", passwords are not checked against dictionaries.\n";
+        return true;
+    }();
+    (void) warned;
+    return graph;
+}
@@ -1,32 +1,556 @@
 #pragma once
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+#include <iosfwd>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <functional>
+#include <iterator>
+
+/**
+    @brief Memory pool for the secrets of opened vaults.
+
+    Memory is taken from a few large regions that are locked in RAM (mlock) and excluded from core
+    dumps (MADV_DONTDUMP). Blocks are bump allocated; freed blocks are zeroed and kept on a free list
+    of their size for reuse. Freed large blocks are joined with free neighbours, and a large request
+    splits the smallest of them that fits. wipe() zeroes every region at once when the vault is closed;
+    it refuses while any block is still handed out, since that block would later be handed out a second time.
+*/
+class SecretArena {
+public:
+    /**
+        @brief Per-thread bump cursor over a span of the arena.
+
+        While a Lease is alive, small blocks allocated by its thread are bumped from a span taken
+        from the arena in one step, so parser threads do not take the arena mutex for every secret.
+        The unused rest of the span is given back to the arena when the Lease ends.
+    */
+    class Lease {
+    public:
+        explicit Lease(SecretArena& arena);
+        Lease(const Lease&) = delete;
+        auto operator=(const Lease&) -> Lease& = delete;
+        ~Lease();
+
+    private:
+        friend class SecretArena;
+
+        SecretArena& arena;
+        Lease* previous;
+        char* next = nullptr;
+        char* end = nullptr;
+        std::uint64_t epoch = 0;
+    };
+
+    SecretArena() = default;
+    SecretArena(const SecretArena&) = delete;
+    auto operator=(const SecretArena&) -> SecretArena& = delete;
+    ~SecretArena();
+
+    auto allocate(std::size_t size) -> void*;
+    auto deallocate(void* p, std::size_t size) -> void;
+    auto wipe() -> void;
+    auto regionCount() -> std::size_t;
+    auto liveCount() const -> std::size_t { return live; }
+
+private:
+    struct Region {
+        char* base;
+        std::size_t size;
+        std::size_t used;
+    };
+
+    auto addRegion(std::size_t minimum) -> void;
+    auto bump(std::size_t size) -> void*;
+    auto refill(Lease& lease) -> void;
+    auto giveBack(Lease& lease) -> void;
+    auto release(void* p, std::size_t size) -> void;
+    auto reset() -> void;
+
+    std::mutex mutex;
+    std::atomic<std::uint64_t> epoch = 0;
+    std::atomic<std::size_t> live = 0;
+    std::vector<Region> regions;
+    std::size_t current = 0;
+    std::array<std::vector<void*>, 64> freeLists;
+    std::map<char*, std::size_t> largeBlocks;
+    bool warned = false;
+};
+
+/**
+    @brief Returns the arena shared by all vault secrets.
+
+    @return A reference to the SecretArena.
+*/
+auto secretArena() -> SecretArena&;
+
+/**
+    @brief Standard allocator that takes its memory from secretArena().
+*/
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    auto allocate(std::size_t n) -> T* {
+        return static_cast<T*>(secretArena().allocate(n * sizeof(T)));
+    }
+
+    auto deallocate(T* p, std::size_t n) -> void {
+        secretArena().deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    auto operator==(const ArenaAllocator<U>&) const -> bool { return true; }
+};
+
+/**
+    @brief String kept in the secret arena.
+*/
+using SecureString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+/**
+    @brief Overwrites a plain text copy of secrets with zeros and empties it.
+
+    @param text The string to wipe.
+*/
+auto wipeString(std::string& text) -> void;
+
+/**
+    @brief Key that unseals the secrets of one opened vault, shared by all of its records.
+*/
+using RecordKey = std::shared_ptr<const std::string>;
+
+/**
+    @brief The sealed secrets of one vault, stored apart from its record index.
+
+    The encrypted body of a vault holds only the record index, where every record refers to its
+    secret by number ("$r$N"). The secrets follow the header as one "[SECRETS] " line of hex blobs
+    made by sealSecret() with the record number as counter; opening a vault only decodes this line,
+    so no password bytes are decrypted until a secret is used.
+*/
+struct SealedSecrets {
+    std::string blobs;
+    std::vector<std::size_t> offsets;
+
+    auto blob(std::uint64_t number) const -> std::string_view;
+};
+
+/**
+    @brief Checks whether a line is the secrets section of a vault.
+
+    @param line The line to check.
+
+    @return true if the line starts with "[SECRETS] ", false otherwise.
+*/
+auto isSecretsSection(std::string_view line) -> bool;
+
+/**
+    @brief Builds the secrets section line from the hex blobs of a vault.
+
+    @param blobs The hex blobs separated by single spaces.
+    @param count The number of blobs.
+
+    @return The "[SECRETS] " line with the count and the CRC32C of the blobs.
+*/
+auto makeSecretsSection(std::string_view blobs, std::size_t count) -> std::string;
+
+/**
+    @brief Checks and decodes the secrets section of a vault, without decrypting any secret.
+
+    @param line The "[SECRETS] " line.
+
+    @return The sealed secrets.
+
+    @throws std::runtime_error if the section is damaged.
+*/
+auto parseSecretsSection(std::string_view line) -> SealedSecrets;
+
+/**
+    @brief A password that is either held in plain text or kept sealed until it is needed.
+
+    Secrets loaded from a vault stay encrypted in memory and are decrypted again on every
+    value() call, so listing or searching by name does not decrypt any passwords and the
+    plain text lives only as long as the caller keeps it. Secrets entered by the user are
+    held in plain text until the vault is saved.
+*/
+class Secret {
+public:
+    Secret() = default;
+    Secret(std::string_view plain);
+    Secret(const std::string& plain) : Secret(std::string_view(plain)) {}
+    Secret(const char* plain) : Secret(std::string_view(plain)) {}
+    Secret(const Secret& other);
+    Secret(Secret&& other) noexcept = default;
+    auto operator=(const Secret& other) -> Secret&;
+    auto operator=(Secret&& other) noexcept -> Secret& = default;
+
+    static auto sealed(RecordKey key, std::string_view blob) -> Secret;
+    static auto fromToken(const std::string& token, const RecordKey& key, const SealedSecrets* secrets = nullptr) -> Secret;
+
+    auto value() const -> SecureString;
+    auto isSealed() const -> bool { return key != nullptr; }
+    auto token(const std::string& recordKey, std::uint64_t counter) const -> std::string;
+
+private:
+    SecureString data;
+    RecordKey key;
+};
+
+auto operator==(const Secret& secret, std::string_view text) -> bool;
+auto operator<<(std::ostream& out, const Secret& secret) -> std::ostream&;
+auto operator>>(std::istream& in, Secret& secret) -> std::istream&;
 
 /**
     @brief Structure representing password data.
 */
 struct PasswordData {
     std::string name;
-    std::string password;
+    Secret password;
     std::string category;
     std::optional<std::string> website;
     std::optional<std::string> login;
 };
 
+/**
+    @brief Wipes the plain text fields of a record with wipeString().
+
+    The password is sealed in the secret arena and is zeroed when it is freed or the arena is wiped.
+
+    @param p The record to wipe.
+*/
+auto wipeRecord(PasswordData& p) -> void;
+
+struct RecordNode;
+
+/**
+    @brief Ordered list of passwords with cheap snapshots.
+
+    The records are kept in a persistent AVL tree ordered by position. Copying a RecordList is O(1)
+    and shares every node; insert(), set() and erase() copy only the O(log n) nodes on the path to
+    the changed position, so a copy taken before a change keeps seeing the old records. Memory used
+    by many snapshots therefore grows with the number of changes, not with the number of records.
+    reordered() rebuilds the tree around the records it already holds, without copying any of them.
+    changes() reports the records one version holds and another does not; it skips the subtrees the
+    two share, so comparing versions a few changes apart takes O(log n) steps per change.
+*/
+class RecordList {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PasswordData;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const PasswordData*;
+        using reference = const PasswordData&;
+
+        Iterator() = default;
+        auto operator*() const -> const PasswordData&;
+        auto operator->() const -> const PasswordData*;
+        auto operator++() -> Iterator&;
+        auto operator++(int) -> Iterator;
+        auto operator==(const Iterator& other) const -> bool;
+
+    private:
+        friend class RecordList;
+        auto descend(const RecordNode* node) -> void;
+
+        std::vector<const RecordNode*> path;
+    };
+
+    RecordList() = default;
+    explicit RecordList(const std::vector<PasswordData>& passwords);
+
+    auto size() const -> std::size_t;
+    auto empty() const -> bool;
+    auto at(std::size_t position) const -> const PasswordData&;
+    auto insert(std::size_t position, const PasswordData& p) -> void;
+    auto pushBack(const PasswordData& p) -> void;
+    auto set(std::size_t position, const PasswordData& p) -> void;
+    auto erase(std::size_t position) -> void;
+    auto reordered(const std::vector<std::uint32_t>& order) const -> RecordList;
+    auto changes(const RecordList& before, const std::function<void(const PasswordData&)>& onRemoved,
+                 const std::function<void(const PasswordData&)>& onAdded) const -> void;
+    auto identical(const RecordList& other) const -> bool;
+    auto toVector() const -> std::vector<PasswordData>;
+    auto begin() const -> Iterator;
+    auto end() const -> Iterator;
+
+private:
+    std::shared_ptr<const RecordNode> root;
+};
+
+/**
+    @brief Index of passwords by website, for autofill-style lookups.
+
+    Websites are normalized with normalizeHost() and stored in a trie keyed by the host labels in
+    reverse order (com -> github -> gist), so a lookup walks at most one node per label of the
+    requested host. The index keeps its own copies of the records; callers keep it current by
+    calling erase() with the old value and insert() with the new one whenever a record changes.
+    clear() wipes those copies and the host labels before dropping them.
+*/
+class WebsiteIndex {
+public:
+    auto insert(const PasswordData& p) -> void;
+    auto erase(const PasswordData& p) -> void;
+    auto lookup(const std::string& url) const -> std::vector<PasswordData>;
+    auto clear() -> void;
+    auto size() const -> std::size_t;
+
+private:
+    struct Node {
+        std::unordered_map<std::string, std::unique_ptr<Node>> children;
+        std::vector<PasswordData> entries;
+    };
+
+    Node root;
+    std::size_t count = 0;
+};
+
+/**
+    @brief Fields compared by fuzzySearch(), in ranking order.
+*/
+enum class FuzzyField {
+    NAME,
+    WEBSITE,
+    LOGIN
+};
+
+/**
+    @brief Structure representing one fuzzySearch() result.
+*/
+struct FuzzyMatch {
+    std::size_t index;
+    int distance;
+    FuzzyField field;
+};
+
+struct QueryNode;
+
+/**
+    @brief Compiled search expression.
+
+    A query is made of terms "field:pattern" (fields name, category, website, login) or just
+    "pattern" (any field), where the pattern is a case-insensitive glob with '*' and '?'. Terms are
+    combined with NOT, AND (also implied between terms), OR and parentheses, with that precedence,
+    e.g. "category:work AND website:*github* AND NOT login:admin".
+
+    The expression is parsed once into a tree of predicates. run() evaluates it column by column:
+    every node scans one field over the rows still undecided, so the right side of AND only sees
+    the rows the left side kept and the right side of OR only the rows it rejected. Large vaults
+    are split in chunks evaluated on all cores.
+*/
+class Query {
+public:
+    explicit Query(const std::string& text);
+    ~Query();
+
+    auto run(const std::vector<PasswordData>& passwords) const -> std::vector<std::size_t>;
+
+private:
+    std::unique_ptr<const QueryNode> root;
+};
+
+/**
+    @brief Runs the --find command line mode.
+
+    "--find VAULT QUERY" opens the vault and prints the passwords matching the Query as tab
+    separated lines (name, password, category, website, login); the number of matches and the
+    time taken are reported on the error stream.
+
+    @param args The command line arguments, starting with "--find".
+
+    @return void
+*/
+auto findCommand(const std::vector<std::string>& args) -> void;
+
+/**
+    @brief Fields the passwords can be sorted by.
+*/
+enum class SortField {
+    NAME,
+    CATEGORY,
+    WEBSITE,
+    LOGIN
+};
+
+constexpr std::size_t sortFieldCount = 4;
+
+/**
+    @brief Structure representing one key of sortOrder().
+*/
+struct SortKey {
+    SortField field;
+    bool descending = false;
+    bool missingFirst = false;
+};
+
+/**
+    @brief Structure representing the outcome of mergeVaults().
+*/
+struct MergeResult {
+    std::vector<PasswordData> merged;
+    std::vector<std::string> conflicts;
+    std::size_t fromOurs = 0;
+    std::size_t fromTheirs = 0;
+    std::size_t fieldMerged = 0;
+};
+
+/**
+    @brief Structure representing password data tagged with the vault it was loaded from.
+*/
+struct VaultRecord {
+    std::string vault;
+    PasswordData data;
+};
+
+/**
+    @brief Prefix of the header line that starts an authenticated vault file.
+*/
+inline const std::string vaultHeaderTag = "[VAULT] ";
+
+/**
+    @brief Interface of the ciphers used for vault bodies.
+
+    An engine is created for one vault body by makeCipherEngine() and processes it in order,
+    in blocks of any size. Authenticated engines produce a tag after encryption and check it
+    after decryption.
+*/
+class CipherEngine {
+public:
+    virtual ~CipherEngine() = default;
+
+    virtual auto name() const -> std::string = 0;
+    virtual auto tagSize() const -> std::size_t = 0;
+    virtual auto encrypt(std::string& data) -> void = 0;
+    virtual auto decrypt(std::string& data) -> void = 0;
+    virtual auto tag() -> std::string = 0;
+    virtual auto finish(const std::string& tag) -> void = 0;
+    virtual auto recordKey() const -> std::string = 0;
+};
+
+/**
+    @brief Advisory lock coordinating the sessions that use one vault.
+
+    The lock is taken with flock() on "<vault>.lock", a file that is never replaced, so it keeps working
+    while saves rename new versions over the vault. Readers share the lock and never wait for each
+    other; a writer holds it alone. The lock is released when the object is destroyed.
+*/
+class VaultLock {
+public:
+    enum Mode {
+        SHARED,
+        EXCLUSIVE
+    };
+
+    /**
+        @brief Takes the lock, waiting (with a message) while a conflicting session holds it.
+
+        A reader that cannot create the lock file reads without it.
+
+        @param file The path to the vault file.
+        @param mode SHARED for reading, EXCLUSIVE for saving.
+
+        @throws std::runtime_error if an exclusive lock cannot be taken.
+    */
+    VaultLock(const std::string& file, Mode mode);
+    ~VaultLock();
+
+    VaultLock(const VaultLock&) = delete;
+    auto operator=(const VaultLock&) -> VaultLock& = delete;
+
+private:
+    int fd = -1;
+};
+
+/**
+    @brief Returns the path of the lock file of a vault.
+
+    @param file The path to the vault file.
+
+    @return The vault path followed by ".lock".
+*/
+auto lockPath(const std::string& file) -> std::string;
+
+/**
+    @brief Reads the generation of a vault from its header.
+
+    Every save increases the generation by one, so a session can tell whether the vault was saved
+    since it was read.
+
+    @param file The path to the vault file.
+
+    @return The "gen=" field of the header, 0 for empty, legacy and older vaults.
+*/
+auto vaultGeneration(const std::string& file) -> std::uint64_t;
+
+/**
+    @brief Reads the generation from an already read header line.
+
+    @param header The first line of the vault.
+
+    @return The "gen=" field of the header, 0 if it is not a vault header or has no generation.
+*/
+auto headerGeneration(std::string_view header) -> std::uint64_t;
+
+/**
+    @brief Structure representing the options of the current session.
+*/
+struct Settings {
+    bool compress = false;
+    std::string vaultFolder;
+    std::string vaultPath;
+};
+
+constexpr std::size_t recentVaultLimit = 10;
+
+/**
+    @brief Returns the options of the current session.
+
+    @return A reference to the session Settings.
+*/
+auto settings() -> Settings&;
+
 /**
     @brief User interface function for managing password data.
 
     This function provides a menu-based user interface for operating on password data.
+    The passwords are kept in a RecordList, and the state before every change is pushed on an undo
+    stack (up to 100 steps), so UNDO and REDO can move through the changes of the session.
+    On EXIT the changes are saved with commitPasswords(); a session without changes leaves the vault as it is.
 
     @param file The file path linked with the password data.
-    @param passwords The vector of PasswordData objects containing the passwords.
+    @param passwords The vector of PasswordData objects containing the passwords; it holds the
+    saved passwords when the function returns.
+    @param generation The generation of the vault when it was read, see vaultGeneration().
+
+    @return void
+*/
+auto userInterface(const std::string& file, std::vector<PasswordData>& passwords, std::uint64_t generation) -> void;
+
+/**
+    @brief Prints a single password entry.
+
+    This function prints the name, password, category, website (if available)
+    and username (if available) of one password.
+
+    @param pData The PasswordData object to print.
 
     @return void
 */
-auto userInterface(const std::string& file, std::vector<PasswordData>& passwords) -> void;
+auto printPassword(const PasswordData& pData) -> void;
 
 /**
     @brief Displays the content of the password list.
@@ -45,6 +569,8 @@ auto displayContent(const std::vector<PasswordData>& passwords) -> void;
 
     This function allows the user to search for specific passwords by entering a name and category.
     It iterates through the passwords list and return the data that match the criteria.
+    Alternatively the user can run a fuzzy search over the name, website and login with a chosen
+    number of allowed typos, see fuzzySearch(), or filter with a Query expression.
     The matching passwords are displayed, including their name, password, category, website (if available),
     and username (if available).
 
@@ -54,18 +580,73 @@ auto displayContent(const std::vector<PasswordData>& passwords) -> void;
 */
 auto searchPasswords(const std::vector<PasswordData>& passwords) -> void;
 
+/**
+    @brief Finds passwords whose name, website or login approximately contain the pattern.
+
+    Every field is compared with Myers' bit-parallel edit distance algorithm (case-insensitive,
+    one 64-bit word per 64 pattern characters), which gives the smallest number of typos between
+    the pattern and any part of the field. Large vaults are scanned on all cores.
+
+    @param passwords The vector of PasswordData objects to search.
+    @param pattern The text to look for.
+    @param maxErrors The maximum number of typos (insertions, deletions, substitutions) allowed.
+
+    @return The matches ranked by number of typos, then by field (name, website, login).
+*/
+auto fuzzySearch(const std::vector<PasswordData>& passwords, const std::string& pattern, int maxErrors) -> std::vector<FuzzyMatch>;
+
+/**
+    @brief Reduces a website or URL to its host name.
+
+    The scheme, user info, port, path, query and fragment are removed, the host is lower-cased and a
+    leading "www." label is dropped, e.g. "https://user@WWW.GitHub.com:443/login" -> "github.com".
+
+    @param url The website as entered by the user or sent by the browser.
+
+    @return The normalized host name.
+*/
+auto normalizeHost(const std::string& url) -> std::string;
+
+/**
+    @brief Prints the passwords saved for a website and its parent domains.
+
+    The parent domains are followed up to the registrable domain, so "mail.google.com" also finds
+    the passwords saved for "google.com", but never those of "com" or "co.uk". The most specific
+    matches are printed first.
+
+    @param index The website index of the opened vault.
+*/
+auto findByWebsite(const WebsiteIndex& index) -> void;
+
 /**
     @brief Sorts the passwords based on selected parameters.
 
-    This function allows the user to sort the passwords based on two selected parameters.
-    The user is asked to choose the sorting parameters (name or category),
-    and then passwords are sorted, then displayed.
+    This function allows the user to sort the passwords by up to four parameters (name, category,
+    website and login), each ascending or descending, and to choose whether passwords without a
+    website and login come first or last. The order comes from sortOrder() and the records are
+    rearranged with RecordList::reordered(), so no record is copied and an unchanged order leaves
+    the list as it is. The time it took is reported, and then the passwords are displayed.
 
-    @param passwords The vector of PasswordData objects containing the passwords.
+    @param records The records of the vault.
 
     @return void
 */
-auto sortPasswords(std::vector<PasswordData>& passwords) -> void;
+auto sortPasswords(RecordList& records) -> void;
+
+/**
+    @brief Computes the sorted order of passwords by several keys.
+
+    Every key is first turned into a column of dense integer ranks that already account for the
+    direction and the place of missing values. The rows of ranks are then sorted by a comparator
+    instantiated for the number of keys, with the original position as the last key, so the sort
+    is stable. Large vaults are sorted with a parallel merge sort.
+
+    @param passwords The passwords to sort.
+    @param keys The keys in order of priority, each field at most once.
+
+    @return The positions of the passwords in sorted order.
+*/
+auto sortOrder(const std::vector<PasswordData>& passwords, const std::vector<SortKey>& keys) -> std::vector<std::uint32_t>;
 
 /**
     @brief Checks if a string contains uppercase letters.
@@ -95,10 +676,9 @@ auto isSpecialChar(const std::string& text) -> bool;
 /**
     @brief Checks if a password meets the requirements for a strong password.
 
-    This function checks if the given password meets the requirements for a strong password. It checks
-    if the password has a minimum length of 8 characters, contains at least one uppercase letter,
-    and contains at least one special character. If it does, it returns true; otherwise,
-    it returns false.
+    This function estimates the password with estimateStrength() and accepts it if it needs at least
+    10^8 guesses (a score of 3 or more), so common words, keyboard walks and dates are rejected even
+    when they have the required character classes.
 
     @param password The password to be checked.
 
@@ -118,7 +698,7 @@ auto isStrong(const std::string& password) -> bool;
 
     @return True if the password is already used, false if not.
 */
-auto isUsed(const std::vector<PasswordData>& passwords, const std::string& password) -> bool;
+auto isUsed(const RecordList& passwords, const std::string& password) -> bool;
 
 /**
     @brief Generates a password based on criteria.
@@ -135,7 +715,7 @@ auto isUsed(const std::vector<PasswordData>& passwords, const std::string& passw
 
     @return The generated password.
 */
-auto passwordGenerator(const std::vector<PasswordData>& passwords, auto& length, bool& uppercase, bool& specialChar) -> std::string;
+auto passwordGenerator(const RecordList& passwords, auto& length, bool& uppercase, bool& specialChar) -> std::string;
 
 /**
     @brief Adds a new password.
@@ -147,12 +727,13 @@ auto passwordGenerator(const std::vector<PasswordData>& passwords, auto& length,
     exist, the program can create it. The user can enter the website and login for the password optionally.
     The entered password is then added to the vector of passwords.
 
-    @param passwords The vector of passwords.
+    @param passwords The list of passwords.
     @param categories The set of categories.
+    @param index The website index, kept in sync with the change.
 
     @return void
 */
-auto addPassword(std::vector<PasswordData>& passwords, std::set<std::string>& categories) -> void;
+auto addPassword(RecordList& passwords, std::set<std::string>& categories, WebsiteIndex& index) -> void;
 
 /**
     @brief Edits an existing password.
@@ -164,12 +745,24 @@ auto addPassword(std::vector<PasswordData>& passwords, std::set<std::string>& ca
     chooses to quit. The function also can create a new category if it does not exist in the set of
     categories.
 
-    @param passwords The vector of passwords.
+    @param passwords The list of passwords.
     @param categories The set of categories.
+    @param index The website index, kept in sync with the change.
+
+    @return void
+*/
+auto editPassword(RecordList& passwords, std::set<std::string>& categories, WebsiteIndex& index) -> void;
+
+/**
+    @brief Removes every password matching a condition.
+
+    @param passwords The list of passwords.
+    @param index The website index, kept in sync with the change.
+    @param matches Returns true for the passwords to remove.
 
     @return void
 */
-auto editPassword(std::vector<PasswordData>& passwords, std::set<std::string>& categories) -> void;
+auto eraseRecords(RecordList& passwords, WebsiteIndex& index, const std::function<bool(const PasswordData&)>& matches) -> void;
 
 /**
     @brief Deletes password.
@@ -179,11 +772,12 @@ auto editPassword(std::vector<PasswordData>& passwords, std::set<std::string>& c
     delete any more passwords. After confirming the operation, the function removes the password(s)
     from the vector. If no matching passwords are found, a message is displayed.
 
-    @param passwords The vector of passwords;
+    @param passwords The list of passwords;
+    @param index The website index, kept in sync with the change.
 
     @return void
 */
-auto deletePassword(std::vector<PasswordData> &passwords) -> void;
+auto deletePassword(RecordList &passwords, WebsiteIndex& index) -> void;
 
 /**
     @brief Prints the available categories.
@@ -219,19 +813,40 @@ auto addCategory(std::set<std::string>& categories) -> void;
     all the password from that category are deleted too.
     If the category is not found, a message is displayed.
 
-    @param passwords The vector of passwords;
+    @param passwords The list of passwords;
     @param categories The set of categories.
+    @param index The website index, kept in sync with the change.
 
     @return void
 */
-auto deleteCategory(std::vector<PasswordData>& passwords, std::set<std::string>& categories) -> void;
+auto deleteCategory(RecordList& passwords, std::set<std::string>& categories, WebsiteIndex& index) -> void;
+
+/**
+    @brief Serializes the passwords to the plain text vault format.
+
+    Every password is written on its own line as name, password and category separated by spaces,
+    followed by the website and login if both are available. With a record key every password is
+    sealed separately, so the vault can later be opened without decrypting them; with a secrets
+    section the sealed passwords go there and the lines only refer to them.
+
+    @param passwords The vector of PasswordData objects to serialize.
+    @param recordKey The record key used to seal the passwords, or an empty string to write them in plain text.
+    @param secrets If not null (and with a record key), receives the secrets section line.
+
+    @return The serialized text.
+*/
+auto serializePasswords(const std::vector<PasswordData>& passwords, const std::string& recordKey = "",
+                        std::string* secrets = nullptr) -> std::string;
 
 /**
     @brief Saves the passwords to a file.
 
-    This function saves the modified/added passwords to a file. It overwrites the existing file
-    with updated data. Then the function encrypts the file using the readEncryptWrite()
-    function and appends the second line [TIMESTAMP] from the original file to the end of the encrypted file.
+    This function asks for the password, serializes the modified/added passwords with every password
+    sealed on its own into the secrets section, compresses the record index when compression is enabled
+    in the session settings (and reports the ratio and throughput), encrypts the result and replaces
+    the file with it, followed by a [TIMESTAMP] line with the time of the save.
+    The save holds the exclusive VaultLock and increases the generation of the vault.
+    Every save is also recorded in the history of the vault, see recordHistory().
 
     @param passwords The vector of PasswordData objects containing the passwords to be saved.
     @param file The path to the file where the passwords will be saved.
@@ -241,123 +856,1074 @@ auto deleteCategory(std::vector<PasswordData>& passwords, std::set<std::string>&
 auto passwordsSave(const std::vector<PasswordData>& passwords, const std::string& file) -> void;
 
 /**
-    @brief Checks if a file is empty.
-
-    This function checks if the specified file is empty by checking if the input stream
-    reaches the end-of-file.
+    @brief Saves the passwords to a file with an already entered password.
 
-    @param file The path to the file to be checked.
+    @param passwords The vector of PasswordData objects containing the passwords to be saved.
+    @param file The path to the file where the passwords will be saved.
+    @param password The password of the vault.
 
-    @return true if the file is empty, false if not.
+    @return void
 */
-auto isFileEmpty(const std::string& file) -> bool;
+auto passwordsSave(const std::vector<PasswordData>& passwords, const std::string& file, const std::string& password) -> void;
 
 /**
-    @brief Selects a file from the available options or allows to enter an absolute path.
+    @brief Saves the changes of a session that started from a known version of the vault.
 
-    This function displays a list of files from project folder and asks the user to
-    select a file by entering the number. Optionally, the user can enter an absolute
-    path to a file. The selected file path is returned.
+    The password is asked before the exclusive VaultLock is taken. If the generation of the vault is
+    still the one the session opened, the passwords are saved as they are. Otherwise another session
+    committed in the meantime: its version is read and merged with this one by mergeVaults(), with
+    the opened version as the base and conflicting fields kept from this session, and the merge is saved.
 
-    @return The selected file path as a string.
+    @param base The passwords as they were when the vault was opened.
+    @param baseGeneration The generation of the vault when it was opened.
+    @param passwords The passwords of this session; they hold the saved (possibly merged) passwords
+    when the function returns.
+    @param file The path to the vault file.
+
+    @return void
+
+    @throws std::runtime_error if the version of the other session cannot be opened with the password.
 */
-auto selectFile() -> std::string;
+auto commitPasswords(const std::vector<PasswordData>& base, std::uint64_t baseGeneration,
+                     std::vector<PasswordData>& passwords, const std::string& file) -> void;
 
 /**
-    @brief Splits a string into a vector of PasswordData objects.
+    @brief Saves the changes made since a known version of the vault with an already entered password.
 
-    This function takes a string as input, each line represents a PasswordData object,
-    separated by white space . The string is split into individual lines, and each
-    line is further divided to the fields for creating a PasswordData object.
-    The new PasswordData objects are stored in a vector and returned.
+    @param base The passwords as they were when the vault was opened.
+    @param baseGeneration The generation of the vault when it was opened.
+    @param passwords The passwords to save; they hold the saved (possibly merged) passwords when the
+    function returns.
+    @param file The path to the vault file.
+    @param password The password of the vault.
 
-    @param input The input string to split.
+    @return void
 
-    @return A vector of PasswordData objects.
+    @throws std::runtime_error if the version of the other session cannot be opened with the password.
 */
-auto splitString(const std::string &input) -> std::vector<PasswordData>;
+auto commitPasswords(const std::vector<PasswordData>& base, std::uint64_t baseGeneration,
+                     std::vector<PasswordData>& passwords, const std::string& file, const std::string& password) -> void;
 
 /**
-    @brief Reads password data from a file and displays the user interface.
+    @brief Three-way merges two diverged copies of a vault.
+
+    Records are matched by name (the n-th record of a name with the n-th of the same name) through
+    hash tables, and compared by fingerprints: a hash of every field and of the whole record, so
+    the merge is O(n). A record changed on one side only takes that side's version, including
+    additions and deletions. A record changed on both sides is merged field by field (password,
+    category, website and login); a field changed differently on both sides is a conflict and
+    takes the preferred side. A record deleted on one side and changed on the other is a conflict
+    and stays. The merged list keeps the order of ours, followed by the records added in theirs.
+
+    @param base The common ancestor.
+    @param ours The local copy.
+    @param theirs The other copy.
+    @param preferTheirs Whether conflicting fields take the value from theirs instead of ours.
+
+    @return The merged passwords, the conflicts and counters of what was taken from where.
+*/
+auto mergeVaults(const std::vector<PasswordData>& base, const std::vector<PasswordData>& ours,
+                 const std::vector<PasswordData>& theirs, bool preferTheirs) -> MergeResult;
 
-    This function reads passwords from a selected file, decrypts, and insert them
-    to the vector of PasswordData objects. Then it calls the userInterface function
-    to display the user interface.
+/**
+    @brief Runs the --merge command line mode.
+
+    "--merge BASE OURS THEIRS [--theirs]" opens the three vaults in parallel, merges them with
+    mergeVaults(), prints the conflicts and timings, and saves the result to OURS once
+    with commitPasswords(), so a save of OURS made after it was loaded is merged in, not overwritten.
+
+    @param args The command line arguments, starting with "--merge".
 
     @return void
 */
-auto fileRead() -> void;
+auto mergeCommand(const std::vector<std::string>& args) -> void;
+
+/**
+    @brief Returns the path of the history kept next to a vault.
+
+    @param file The path of the vault.
+
+    @return The path of the history file ("<vault>.history").
+*/
+auto historyPath(const std::string& file) -> std::string;
 
 /**
-    @brief Reads the content of a file, encrypts it, and writes the encrypted text to the file.
+    @brief Appends the saved content of a vault to its history.
 
-    This function reads the content of the file, encrypts the text, and writes
-    the encrypted text to the same file, overwriting its previous content.
+    The history file starts with its own [VAULT] header (salt and KDF parameters) and holds one
+    [VERSION] line per save, sealed with ChaCha20-Poly1305 under a key derived from the vault
+    password, with the version number as the nonce. A version is normally stored as a compressed
+    delta against the previous one: runs of records copied from it plus the records that are new.
+    Every 16th version, and whenever the delta would be more than half of the full content, a full
+    checkpoint is written instead. If the history cannot be opened with the password it is moved
+    to "<history>.old.N" (never over an earlier one) and a new one is started.
 
-    @param file The path to the file to be read, encrypted, and written.
+    @param file The path of the vault.
+    @param password The password the vault was saved with.
+    @param data The serialized passwords, one record per line, with plain passwords.
 
     @return void
 */
-auto readEncryptWrite(const std::string& file) -> void;
+auto recordHistory(const std::string& file, const std::string& password, const std::string& data) -> void;
 
 /**
-    @brief Encrypts the given text using a password.
+    @brief Reseals every version of the history of a vault under a new password.
 
-    This function encrypts the text using a password. The password is used for XOR encryption,
-    where each character of the text is applied a XOR operation with the corresponding character from the password.
+    The versions are opened with the old password and sealed again, unchanged, under a new header;
+    they are written to a staged copy next to the history, which the caller puts in place with
+    replacePath().
 
-    @param text The text to be encrypted.
+    @param file The path of the vault.
+    @param oldPassword The password the history was written with.
+    @param newPassword The new password.
 
-    @return The encrypted text.
+    @return The path of the staged copy, or an empty string if the vault has no history.
+
+    @throws std::runtime_error if a version cannot be opened with the old password.
 */
-auto encryptText(const std::string& text) -> std::string;
+auto rekeyHistory(const std::string& file, const std::string& oldPassword, const std::string& newPassword) -> std::string;
 
 /**
-    @brief Decrypts the text using a password.
+    @brief Re-encrypts one vault under a new password.
 
-    This function decrypts the text by converting the hexadecimal characters to unicode,
-    then apply a XOR operation with the password characters to get the decrypted text.
+    Under the exclusive VaultLock the vault is opened with the old password, every record is sealed
+    again with the new record key and the vault is replaced atomically with a new generation. Legacy
+    XOR vaults are refused, because a wrong old password cannot be detected for them.
+    The history and the backup store are re-keyed under the same lock, so no save can append to them
+    under the old password in between. Both are re-keyed into staged copies before the vault is
+    written, so a failure leaves all three under the old password; the copies are swapped in after.
 
-    @param text The text to be decrypted.
+    @param file The path of the vault.
+    @param oldPassword The current password.
+    @param newPassword The new password.
 
-    @return The decrypted text.
+    @return The number of passwords in the vault.
+
+    @throws std::runtime_error if the vault cannot be opened with the old password or written, or if
+    its history or backup store could not be re-keyed.
 */
-auto decryptText(const std::string& text) -> std::string;
+auto rekeyVault(const std::string& file, const std::string& oldPassword, const std::string& newPassword) -> std::size_t;
 
 /**
-    @brief Adds or modifies a timestamp in the file.
+    @brief Runs the "--rekey OLD_KEY_FILE NEW_KEY_FILE VAULT... [--jobs N]" command.
 
-    This function reads the content of the file line by line. If a line starts with "[TIMESTAMP] ",
-    it replaces it with the modified timestamp. If no such line is found, it appends a new line with
-    the current timestamp at the end of the file.
+    The old and new passwords are the first lines of the key files, which may also be descriptors
+    such as /dev/fd/3. The vaults are re-keyed (with their history) by a pool of N workers, one
+    vault per worker at a time; the time and result of every vault are printed as it finishes.
+    A vault whose history or backups could not be re-keyed counts as failed.
 
-    @param file The path to the file.
+    @param args The command line arguments, starting with "--rekey".
 
-    @return void
+    @return The exit code: 0 if every vault was re-keyed, 1 otherwise.
 */
-auto makeTimestamp(const std::string& file) -> void;
+auto rekeyCommand(const std::vector<std::string>& args) -> int;
 
 /**
-    @brief Get the second line from a file.
+    @brief Materializes a past version of a vault from its history.
 
-    This function opens the file, reads the first two lines, and returns the second line as a string.
+    Only the checkpoint before the version and the deltas after it are decrypted and applied.
 
-    @param file The path to the file.
+    @param file The path of the vault.
+    @param password The password of the history.
+    @param version The version number to materialize.
 
-    @return The second line from the file.
+    @return The passwords of that version.
 */
-auto secondLine(const std::string &file) -> std::string;
+auto historyVersion(const std::string& file, const std::string& password, std::uint64_t version) -> std::vector<PasswordData>;
 
 /**
-    @brief Modifies the content of the file with the new content.
+    @brief Runs the --history command line mode.
 
-    This function opens the file in output mode and replaces its content with the new content
+    "--history VAULT" lists the versions without asking for the password, "--history VAULT show N"
+    prints version N and "--history VAULT restore N" saves version N as the current content of the
+    vault (which becomes a new version of the history).
 
-    @param file The path to the file.
-    @param data The new content to be written to the file.
+    @param args The command line arguments, starting with "--history".
 
     @return void
 */
-auto fileModify(const std::string& file, const std::string& data) -> void;
+auto historyCommand(const std::vector<std::string>& args) -> void;
+
+/**
+    @brief Sizes of the content-defined chunks of a backup: no cut before the minimum, most cuts near
+           the average and a forced cut at the maximum.
+*/
+constexpr std::size_t minimumBackupChunk = 2 * 1024;
+constexpr std::size_t averageBackupChunk = 8 * 1024;
+constexpr std::size_t maximumBackupChunk = 64 * 1024;
+
+/**
+    @brief Returns the path of the backup store kept next to a vault.
+
+    @param file The path of the vault.
+
+    @return The path of the store directory ("<vault>.backup").
+*/
+auto backupPath(const std::string& file) -> std::string;
+
+/**
+    @brief Stores a deduplicated backup of the saved content of a vault.
+
+    The serialized records are cut into chunks where a rolling (Gear) hash of the last bytes matches
+    a mask, so an edit only changes the chunks around it. Every chunk is identified by a keyed hash
+    of its content; chunks that are not in the store yet are compressed, sealed with ChaCha20-Poly1305
+    and written to "chunks/", so a backup costs only the chunks that changed. The backup itself is a
+    small sealed manifest in "manifests/" listing its chunks in order. The keys are derived from a
+    random store key kept in the STORE file, sealed under the vault password; if the store cannot be
+    opened with the password it is moved to "<store>.old.N" (never over an earlier one) and a new
+    one is started.
+
+    @param file The path of the vault.
+    @param password The password the vault was saved with.
+    @param data The serialized passwords, one record per line, with plain passwords.
+
+    @return The number of the new backup.
+*/
+auto backupVault(const std::string& file, const std::string& password, const std::string& data) -> std::uint64_t;
+
+/**
+    @brief Moves the backups of a vault to a new store key under a new password.
+
+    Every chunk and manifest is opened with the old store key and sealed again under a new random
+    one, so the old STORE file and password open none of them afterwards. The new store is built
+    next to the old one; the caller swaps it in with replacePath().
+
+    @param file The path of the vault.
+    @param oldPassword The password the backups were written with.
+    @param newPassword The new password.
+
+    @return The path of the new store, or an empty string if the vault has no backups.
+
+    @throws std::runtime_error if the store cannot be opened with the old password or a backup is damaged.
+*/
+auto rekeyBackups(const std::string& file, const std::string& oldPassword, const std::string& newPassword) -> std::string;
+
+/**
+    @brief Restores the passwords of one backup.
+
+    The chunks are read, opened and parsed one after another in the order of the manifest, so only
+    one chunk is held besides the records. The vault's shared VaultLock is held while reading.
+
+    @param file The path of the vault.
+    @param password The password of the backup store.
+    @param number The number of the backup.
+
+    @return The passwords of the backup.
+
+    @throws std::runtime_error if the backup does not exist, the password is wrong or a chunk is damaged or missing.
+*/
+auto backupRecords(const std::string& file, const std::string& password, std::uint64_t number) -> std::vector<PasswordData>;
+
+/**
+    @brief Runs the --backup command line mode.
+
+    "--backup VAULT" lists the backups and the space they take without asking for the password,
+    "--backup VAULT create" backs up the vault as it is now, "--backup VAULT show N" prints backup N
+    and "--backup VAULT restore N" saves backup N as the current content of the vault.
+
+    @param args The command line arguments, starting with "--backup".
+
+    @return void
+*/
+auto backupCommand(const std::vector<std::string>& args) -> void;
+
+/**
+    @brief Checks if a file is empty.
+
+    This function checks if the specified file is empty by checking if the input stream
+    reaches the end-of-file.
+
+    @param file The path to the file to be checked.
+
+    @return true if the file is empty, false if not.
+*/
+auto isFileEmpty(const std::string& file) -> bool;
+
+/**
+    @brief Returns the folder scanned for vault files.
+
+    The folder is taken from the --folder option, then from the PM_VAULT_DIR environment variable,
+    and is the current directory otherwise.
+
+    @return The default vault folder path.
+*/
+auto defaultVaultFolder() -> std::string;
+
+/**
+    @brief Returns the path of the recently used vaults cache.
+
+    @return "$XDG_CACHE_HOME/projektpjc-recent" or "$HOME/.cache/projektpjc-recent", or an empty
+    string if neither variable is set.
+*/
+auto recentVaultsPath() -> std::string;
+
+/**
+    @brief Reads the recently used vaults, most recent first.
+
+    @return The paths from the cache that still exist.
+*/
+auto recentVaults() -> std::vector<std::string>;
+
+/**
+    @brief Moves a vault to the front of the recently used vaults cache.
+
+    The cache keeps up to recentVaultLimit absolute paths and is replaced atomically.
+
+    @param file The path of the opened vault.
+
+    @return void
+*/
+auto rememberVault(const std::string& file) -> void;
+
+/**
+    @brief Lists the vault files available in a folder.
+
+    This function scans the folder once and collects every regular ".txt" file
+    (except CMakeLists.txt) in directory order.
+
+    @param folderPath The folder to scan.
+
+    @return The vector of vault file paths.
+*/
+auto discoverVaults(const std::string& folderPath) -> std::vector<std::string>;
+
+/**
+    @brief Selects a file from the available options or allows to enter an absolute path.
+
+    This function displays the recently used vaults, so no folder has to be scanned, and asks the
+    user to select a file by entering the number. The vault folder is only scanned when there are
+    no recent vaults or the user asks for it. Optionally, the user can enter an absolute
+    path to a file. The selected file path is returned.
+
+    @return The selected file path as a string.
+*/
+auto selectFile() -> std::string;
+
+/**
+    @brief Parses one line of decrypted vault text.
+
+    The line holds the name, password and category separated by white space, optionally
+    followed by the website and login. With a record key, sealed passwords are kept sealed.
+
+    @param line The line to parse.
+    @param key The record key of the vault, or nullptr for vaults without sealed passwords.
+    @param secrets The secrets section of the vault, or nullptr if it has none.
+
+    @return The parsed PasswordData object.
+*/
+auto parseLine(std::string_view line, const RecordKey& key = nullptr, const SealedSecrets* secrets = nullptr) -> PasswordData;
+
+/**
+    @brief Smallest amount of decrypted text handed to one parsing thread.
+*/
+constexpr std::size_t minimumParseChunk = 1 << 20;
+
+/**
+    @brief Parses decrypted vault text into records on several threads.
+
+    The text is cut at line ends into one chunk per thread (at least minimumParseChunk bytes each),
+    every thread parses its chunk into its own block of records, and the blocks are joined in their
+    original order. Nothing is shared between the threads while they parse.
+
+    @param text The decrypted text, one record per line.
+    @param key The record key of the vault, or nullptr for vaults without sealed passwords.
+    @param threadCount The number of threads, 0 for one per core.
+    @param secrets The secrets section of the vault, or nullptr if it has none.
+
+    @return The records in the order of the lines.
+*/
+auto parseRecords(std::string_view text, const RecordKey& key = nullptr, std::size_t threadCount = 0,
+                  const SealedSecrets* secrets = nullptr) -> std::vector<PasswordData>;
+
+/**
+    @brief Splits a string into a vector of PasswordData objects.
+
+    This function takes a string as input, each line represents a PasswordData object,
+    separated by white space . The string is split into individual lines, and each
+    line is further divided to the fields for creating a PasswordData object.
+    Compressed input is detected and decompressed first. Large inputs are parsed in parallel
+    with parseRecords().
+    The new PasswordData objects are stored in a vector and returned.
+
+    @param input The input string to split.
+    @param key The record key of the vault, or nullptr for vaults without sealed passwords.
+    @param secrets The secrets section of the vault, or nullptr if it has none.
+
+    @return A vector of PasswordData objects.
+*/
+auto splitString(const std::string &input, const RecordKey& key = nullptr, const SealedSecrets* secrets = nullptr)
+    -> std::vector<PasswordData>;
+
+/**
+    @brief Reads the encrypted body of a vault file.
+
+    This function reads the file line by line and returns every line except the
+    "[TIMESTAMP] " line, ready to be passed to decryptText().
+
+    @param file The path to the vault file.
+
+    @return The encrypted body of the file.
+*/
+auto readVaultBody(const std::string& file) -> std::string;
+
+/**
+    @brief Structure describing how a vault was stored, filled in while it is read.
+
+    Every read fills its own VaultInfo, so vaults read in parallel never share it; a vault is
+    written back the way it was read.
+*/
+struct VaultInfo {
+    std::uint64_t generation = 0;
+    bool compressed = false;
+};
+
+/**
+    @brief Reads, decrypts and parses a whole vault file without asking the user.
+
+    Passwords stay sealed; they are decrypted on demand with the vault's record key.
+
+    The vault is read under a shared VaultLock.
+
+    @param file The path to the vault file.
+    @param password The file password.
+    @param info Optional VaultInfo to fill in.
+
+    @return A vector of PasswordData objects, empty if the file is empty.
+
+    @throws std::runtime_error if the password is wrong or the file was modified.
+*/
+auto loadVault(const std::string& file, const std::string& password, VaultInfo* info = nullptr) -> std::vector<PasswordData>;
+
+/**
+    @brief Reads, decrypts and parses a vault file in overlapped stages.
+
+    This function runs the open path as a three stage pipeline connected by bounded queues.
+    A reader thread reads the file in 64 KiB blocks (skipping the "[TIMESTAMP] " line), a
+    decrypter thread decrypts every block as soon as it arrives, and the calling thread cuts the
+    decrypted text at line ends into chunks of about minimumParseChunk bytes that a pool of parser
+    threads (one per core) turn into records while the earlier stages keep working. Every chunk is
+    parsed into its own block, and the blocks are joined in file order at the end. The total time
+    therefore approaches the slowest stage instead of the sum of all of them. Only the record index
+    is decrypted; the secrets section is decoded before it and the passwords stay sealed until
+    they are used.
+
+    @param file The path to the vault file.
+    @param password The file password.
+    @param onUnverifiedRecord Optional callback called on the calling thread for every record, in file
+                              order, as soon as its chunk and every earlier chunk are parsed. The records
+                              are NOT authenticated yet: the tag is only verified once readPipeline()
+                              returns without throwing, so a modified vault reaches the callback before it
+                              is rejected. Use it for progress and timing; act on the returned records only.
+    @param info Optional VaultInfo to fill in.
+
+    @return A vector of PasswordData objects in file order.
+
+    @throws std::runtime_error if the file cannot be read, the password is wrong or the file was modified.
+*/
+auto readPipeline(const std::string& file, const std::string& password,
+                  const std::function<void(const PasswordData&)>& onUnverifiedRecord = nullptr,
+                  VaultInfo* info = nullptr) -> std::vector<PasswordData>;
+
+/**
+    @brief Reads, decrypts and parses a vault from an already opened stream.
+
+    @param stream The vault, positioned at its beginning.
+    @param password The file password.
+    @param onUnverifiedRecord Optional callback called for every record, in file order, as soon as it
+                              is parsed and before the vault is authenticated; see the overload above.
+    @param info Optional VaultInfo to fill in.
+
+    @return A vector of PasswordData objects in file order.
+*/
+auto readPipeline(std::istream& stream, const std::string& password,
+                  const std::function<void(const PasswordData&)>& onUnverifiedRecord = nullptr,
+                  VaultInfo* info = nullptr) -> std::vector<PasswordData>;
+
+/**
+    @brief Measures how long it takes to start with a vault.
+
+    This function reports the time to list the recent vaults and to scan the vault folder, then
+    opens the vault twice: cold, after asking the kernel to drop its cached pages, and warm. Each
+    open also reports when the first record became available.
+
+    @param file The path to the vault file.
+
+    @return void
+*/
+auto startupBenchmark(const std::string& file) -> void;
+
+/**
+    @brief Reads password data from a file and displays the user interface.
+
+    This function reads passwords from a selected file (or the vault given on the command line),
+    decrypts, and insert them to the vector of PasswordData objects using readPipeline(). The vault is
+    only read, under a shared VaultLock, together with its generation. The time spent
+    selecting and opening the vault is reported. Then it calls the userInterface function
+    to display the user interface.
+
+    @return void
+*/
+auto fileRead() -> void;
+
+/**
+    @brief Opens several vaults at once and displays a merged, read-only view.
+
+    This function lists the vaults found in the default folder, lets the user select
+    any number of them and asks for their passwords. The selected vaults are then
+    decrypted and parsed concurrently by openVaults() and can be displayed, searched
+    and listed together. Every result is tagged with its source vault.
+
+    @return void
+*/
+auto multiVaultRead() -> void;
+
+/**
+    @brief Decrypts and parses several vaults concurrently.
+
+    This function opens the files on a pool of worker threads (one per core, but no more
+    than the number of files). Each worker reads, decrypts and parses whole vaults, so the
+    wall-clock time scales with the number of cores rather than with the number of vaults.
+    Vaults that fail to open are reported and skipped.
+
+    @param files The paths of the vault files.
+    @param passwords The password of each vault, in the same order as files.
+
+    @return The records of all vaults, tagged with their vault and kept in file order.
+*/
+auto openVaults(const std::vector<std::string>& files, const std::vector<std::string>& passwords) -> std::vector<VaultRecord>;
+
+/**
+    @brief Returns the path of the agent's Unix domain socket.
+
+    The path is taken from the PM_AGENT_SOCK environment variable, or defaults to
+    $XDG_RUNTIME_DIR/projektpjc.sock, or /tmp/projektpjc-<uid>/agent.sock when XDG_RUNTIME_DIR is unset.
+
+    @return The socket path.
+*/
+auto agentSocketPath() -> std::string;
+
+/**
+    @brief Unlocks a vault once and serves lookups to local clients.
+
+    This function decrypts the vault, locks the process memory and listens on the agent socket.
+    The socket directory must be owned by the user with mode 0700, and the agent refuses to start
+    while another agent answers on the socket.
+    Every client connection is handled on its own thread and sends requests of one line each:
+    "GET <name>", "SITE <url>" (the website index), "SEARCH <text>" or "LIST". Records are answered as tab separated lines
+    (LIST omits passwords), followed by an "END" line. Queries take a shared lock, so any number
+    of clients can read at once. After idleTimeout seconds without requests the secrets are wiped
+    and the agent exits.
+
+    @param file The path to the vault file.
+    @param idleTimeout The number of idle seconds after which the vault is locked.
+
+    @return void
+*/
+auto runAgent(const std::string& file, int idleTimeout) -> void;
+
+/**
+    @brief Sends one request to a running agent and prints the answer.
+
+    @param request The request line, for example "GET github".
+
+    The request is only sent if the process behind the socket runs as the same user.
+
+    @return 0 on success, 1 if no agent is running or the request failed.
+*/
+auto agentQuery(const std::string& request) -> int;
+
+/**
+    @brief Checks if a text was produced by compressText().
+
+    @param text The text to check.
+
+    @return True if the text starts with the compressed format marker, false if not.
+*/
+auto isCompressed(std::string_view text) -> bool;
+
+/**
+    @brief Compresses a text with the built-in LZ codec.
+
+    The output starts with a format marker and the original size, followed by the text compressed
+    in the LZ4 block format. The repeated categories and websites of a vault compress well.
+
+    @param text The text to compress.
+
+    @return The compressed text.
+*/
+auto compressText(const std::string& text) -> std::string;
+
+/**
+    @brief Restores a text compressed with compressText().
+
+    @param data The compressed text.
+
+    @return The original text.
+
+    @throws std::runtime_error if the data is not compressed or is corrupted.
+*/
+auto decompressText(const std::string& data) -> std::string;
+
+/**
+    @brief Creates the cipher engine for a vault body.
+
+    An empty header selects the legacy repeating-key XOR cipher, so old vaults can still be opened
+    (and are migrated when saved). Otherwise the "[VAULT] " header line names the cipher and the key
+    derivation parameters; the key is derived with PBKDF2-HMAC-SHA256 and the body is processed with
+    ChaCha20-Poly1305, using the header line as associated data. The ChaCha20 keystream is generated
+    eight blocks at a time by an AVX2 kernel when the processor supports it.
+
+    @param header The "[VAULT] " header line of the file, or an empty string for legacy files.
+    @param password The file password.
+
+    @return The cipher engine.
+
+    @throws std::runtime_error if the header names an unsupported cipher or is corrupted.
+*/
+auto makeCipherEngine(const std::string& header, const std::string& password) -> std::unique_ptr<CipherEngine>;
+
+/**
+    @brief Seals one record secret with ChaCha20-Poly1305.
+
+    The nonce is built from the counter, which must be unique for the key. Every save derives
+    a new record key, so numbering the records of one save is enough.
+
+    @param recordKey The record key of the vault, see CipherEngine::recordKey().
+    @param counter The number of the record within the save.
+    @param plain The secret to seal.
+
+    @return The nonce, ciphertext and tag.
+*/
+auto sealSecret(const std::string& recordKey, std::uint64_t counter, std::string_view plain) -> std::string;
+
+/**
+    @brief Seals a secret with ChaCha20-Poly1305 under a random 96-bit nonce.
+
+    For long-lived keys that have no counter which is guaranteed never to repeat.
+
+    @param recordKey The key to seal with.
+    @param plain The secret to seal.
+
+    @return The nonce, ciphertext and tag, opened by openSecret().
+*/
+auto sealSecret(const std::string& recordKey, std::string_view plain) -> std::string;
+
+/**
+    @brief Opens a secret sealed by sealSecret().
+
+    @param recordKey The record key of the vault.
+    @param blob The nonce, ciphertext and tag.
+
+    @return The secret, kept in the secret arena.
+
+    @throws std::runtime_error if the secret was modified.
+*/
+auto openSecret(const std::string& recordKey, std::string_view blob) -> SecureString;
+
+/**
+    @brief Creates a header line for a new vault body, with a fresh random salt and nonce.
+
+    The header is authenticated together with the body, so the generation cannot be changed without
+    the password.
+
+    @param generation The save counter of the vault, see vaultGeneration(); 0 leaves it out.
+
+    @return The "[VAULT] " header line.
+*/
+auto newVaultHeader(std::uint64_t generation = 0) -> std::string;
+
+/**
+    @brief Returns the name of the ChaCha20 kernel selected for this processor ("avx2" or "scalar").
+*/
+auto cipherKernel() -> std::string;
+
+/**
+    @brief Size of the body blocks that get their own checksum in the block table.
+*/
+constexpr std::size_t checksumBlockSize = 64 * 1024;
+
+/**
+    @brief Structure representing the "[BLOCKS] " line written after the vault header.
+
+    The line holds the block size, the length of the body (the hex line after it) and the CRC32C of
+    every block of the body, so damage can be found without the password.
+*/
+struct BlockTable {
+    std::size_t blockSize = 0;
+    std::size_t length = 0;
+    std::vector<std::uint32_t> checksums;
+};
+
+/**
+    @brief Checks a vault body against its block table while it is being read.
+
+    The body can be passed in pieces of any size; a damaged block is reported as soon as it is complete.
+*/
+class BlockVerifier {
+public:
+    explicit BlockVerifier(BlockTable table);
+
+    /**
+        @throws std::runtime_error naming the block if a completed block does not match its checksum.
+    */
+    auto update(std::string_view data) -> void;
+
+    /**
+        @throws std::runtime_error if the body ended before its last block.
+    */
+    auto finish() -> void;
+
+private:
+    auto check() -> void;
+
+    BlockTable table;
+    std::size_t block = 0;
+    std::size_t filled = 0;
+    std::uint32_t crc = 0;
+};
+
+/**
+    @brief Computes the CRC32C (Castagnoli) checksum of the data.
+
+    The SSE4.2 crc32 instruction is used when the processor has it, slicing-by-8 tables otherwise.
+
+    @param data The data.
+    @param crc The checksum of the preceding data, to continue it.
+
+    @return The checksum.
+*/
+auto crc32c(std::string_view data, std::uint32_t crc = 0) -> std::uint32_t;
+
+/**
+    @brief Returns the name of the CRC32C kernel selected for this processor ("sse4.2" or "software").
+*/
+auto checksumKernel() -> std::string;
+
+/**
+    @brief Builds the block table line of a vault body.
+
+    @param body The hex body of the vault.
+
+    @return The "[BLOCKS] " line.
+*/
+auto makeBlockTable(std::string_view body) -> std::string;
+
+/**
+    @brief Checks whether a line is a block table.
+*/
+auto isBlockTable(std::string_view line) -> bool;
+
+/**
+    @brief Parses a block table line.
+
+    @throws std::runtime_error if the line is damaged.
+*/
+auto parseBlockTable(const std::string& line) -> BlockTable;
+
+/**
+    @brief Checks every block of a vault against its block table, without the password.
+
+    The file is memory mapped and its blocks are checked by all cores. The secrets section, if any,
+    is checked against its own checksum.
+
+    @param file The path to the vault file.
+
+    @return The numbers of the damaged blocks, empty if the vault is intact.
+
+    @throws std::runtime_error if the vault has no block table or its secrets section is damaged.
+*/
+auto verifyVault(const std::string& file) -> std::vector<std::size_t>;
+
+/**
+    @brief Runs the "--verify VAULT..." command and reports the result and the speed for every vault.
+
+    @param args The command line arguments, starting with "--verify".
+
+    @return The exit code: 0 if every vault is intact, 1 otherwise.
+*/
+auto verifyCommand(const std::vector<std::string>& args) -> int;
+
+/**
+    @brief Enum representing the word lists of the word graph.
+*/
+enum class WordList : std::uint8_t {
+    PASSWORDS,
+    ENGLISH,
+    NAMES
+};
+
+/**
+    @brief A word found in the word graph: the list it comes from and its rank there (1 is the most common).
+*/
+struct WordEntry {
+    WordList list;
+    std::uint32_t rank;
+};
+
+constexpr std::uint32_t wordListShift = 28;
+constexpr std::uint32_t wordRankMask = (1u << wordListShift) - 1;
+
+/**
+    @brief Read-only word graph (a minimal acyclic automaton) memory mapped from a file built by buildWordGraph().
+
+    Every node knows how many words lie below it, so walking the graph also yields the index of a word,
+    which gives its list and rank without storing the words themselves. The file is used in place and
+    not parsed; opening it costs an mmap and one pass checking its offsets. A missing or damaged file
+    gives an empty graph.
+*/
+class WordGraph {
+public:
+    /**
+        @brief Position in the graph after some characters: the node and the index of the first word below it.
+    */
+    struct Cursor {
+        std::uint32_t node;
+        std::uint32_t index;
+    };
+
+    explicit WordGraph(const std::string& file);
+    ~WordGraph();
+    WordGraph(const WordGraph&) = delete;
+    auto operator=(const WordGraph&) -> WordGraph& = delete;
+
+    auto empty() const -> bool;
+    auto size() const -> std::size_t;
+    auto start() const -> Cursor;
+
+    /**
+        @brief Follows one (lowercase) character from the cursor.
+
+        @return The new cursor, or std::nullopt if no word continues with the character.
+    */
+    auto next(Cursor cursor, char c) const -> std::optional<Cursor>;
+
+    /**
+        @brief Returns the word that ends at the cursor, if any.
+    */
+    auto word(Cursor cursor) const -> std::optional<WordEntry>;
+
+    /**
+        @brief Looks up a whole (lowercase) word.
+    */
+    auto find(std::string_view text) const -> std::optional<WordEntry>;
+
+private:
+    void* base = nullptr;
+    std::size_t mappedSize = 0;
+    const char* nodes = nullptr;
+    const char* edges = nullptr;
+    const std::uint32_t* values = nullptr;
+    std::uint32_t rootNode = 0;
+    std::uint32_t wordCount = 0;
+};
+
+/**
+    @brief Compiles ranked word lists into a word graph file.
+
+    Every list has one word per line, most common first; empty lines and lines starting with '#' are skipped.
+    The lists are numbered in the order of WordList.
+
+    @param lists The paths to the word lists.
+    @param output The path of the word graph file to write.
+
+    @return The number of distinct words.
+*/
+auto buildWordGraph(const std::vector<std::string>& lists, const std::string& output) -> std::size_t;
+
+/**
+    @brief Returns the word graph of the program, mapped on first use.
+
+    The graph is taken from the PM_WORD_GRAPH environment variable, or from words.graph next to the executable.
+*/
+auto wordGraph() -> const WordGraph&;
+
+/**
+    @brief Structure representing the estimated strength of a password.
+*/
+struct StrengthEstimate {
+    double guessesLog10 = 0;
+    int score = 0;
+    std::string warning;
+};
+
+/**
+    @brief Estimates how many guesses an attacker needs for a password.
+
+    The password is split into the most guessable sequence of patterns: words of the word graph (also
+    reversed, capitalized or with l33t substitutions), keyboard walks, repeats, sequences, dates and years,
+    with brute force for the rest. The score goes from 0 (fewer than 10^3 guesses) to 4 (at least 10^10).
+
+    @param password The password to be checked.
+
+    @return The estimate, with a warning naming the weakest pattern if the score is 2 or less.
+*/
+auto estimateStrength(std::string_view password) -> StrengthEstimate;
+
+/**
+    @brief Runs the "--audit VAULT" command: estimates every password of a vault and lists the weak ones.
+
+    @param args The command line arguments, starting with "--audit".
+
+    @return The exit code: 0 if every password is strong, 1 otherwise.
+*/
+auto auditCommand(const std::vector<std::string>& args) -> int;
+
+/**
+    @brief Computes the SHA-256 digest of the data.
+
+    @param data The data to hash.
+
+    @return The 32 byte digest.
+*/
+auto sha256(const std::string& data) -> std::string;
+
+/**
+    @brief Computes the HMAC-SHA256 of the data.
+
+    @param key The key.
+    @param data The data to authenticate.
+
+    @return The 32 byte MAC.
+*/
+auto hmacSha256(const std::string& key, const std::string& data) -> std::string;
+
+/**
+    @brief Derives a 32 byte key from a password with PBKDF2-HMAC-SHA256.
+
+    @param password The password.
+    @param salt The salt.
+    @param iterations The number of iterations.
+
+    @return The derived key.
+*/
+auto pbkdf2Sha256(const std::string& password, const std::string& salt, std::uint32_t iterations) -> std::string;
+
+/**
+    @brief Returns random bytes from the system random device.
+
+    @param count The number of bytes.
+
+    @return The random bytes.
+*/
+auto randomBytes(std::size_t count) -> std::string;
+
+/**
+    @brief Encodes bytes as lowercase hexadecimal text.
+
+    @param data The bytes to encode.
+
+    @return The hexadecimal text.
+*/
+auto toHex(const std::string& data) -> std::string;
+
+/**
+    @brief Decodes hexadecimal text, ignoring any other characters (such as line breaks).
+
+    @param text The hexadecimal text.
+
+    @return The decoded bytes.
+*/
+auto fromHex(const std::string& text) -> std::string;
+
+/**
+    @brief Asks the user for the file password.
+
+    @return The entered password.
+*/
+auto readPassword() -> std::string;
+
+/**
+    @brief Encrypts the given text with an engine created for the given header.
+
+    The result is the header line, the block table, the secrets section (if any) and a line with the
+    ciphertext and the authentication tag encoded as hexadecimal.
+
+    @param text The text to be encrypted.
+    @param header The header line the engine was created for.
+    @param engine The cipher engine, see makeCipherEngine().
+    @param secrets The secrets section line, stored unencrypted between the block table and the body.
+
+    @return The header line followed by the encrypted text.
+*/
+auto encryptText(const std::string& text, const std::string& header, CipherEngine& engine,
+                 const std::string& secrets = "") -> std::string;
+
+/**
+    @brief Decrypts the text using the given password, without asking the user.
+
+    Text starting with a "[VAULT] " header is decrypted with the cipher named in the header and its
+    authentication tag is checked. Text without a header is a legacy vault: the hexadecimal characters
+    are converted to bytes and a XOR operation with the password characters is applied.
+
+    @param text The text to be decrypted.
+    @param password The password used for decryption.
+    @param recordKey If not null, receives the record key of the vault (nullptr for legacy vaults).
+    @param secrets If not null, receives the secrets section of the vault (left empty if it has none).
+
+    @return The decrypted text.
+
+    @throws std::runtime_error if the password is wrong or the text was modified.
+*/
+auto decryptText(const std::string& text, const std::string& password, RecordKey* recordKey = nullptr,
+                 SealedSecrets* secrets = nullptr) -> std::string;
+
+/**
+    @brief Returns the current local time as written in [TIMESTAMP] lines.
+
+    @return The time in the "%Y-%m-%d %H:%M:%S" format.
+*/
+auto currentTimestamp() -> std::string;
+
+/**
+    @brief Modifies the content of the file with the new content.
+
+    The new content is written to "<file>.tmp", flushed to disk and renamed over the file, so readers
+    never see a partly written file.
+
+    @param file The path to the file.
+    @param data The new content to be written to the file.
+
+    @return void
+*/
+auto fileModify(const std::string& file, const std::string& data) -> void;
+
+/**
+    @brief Moves a file or directory aside without replacing anything moved aside before.
+
+    The path is renamed to "<path>.old.N" with the first N that is not taken yet.
+
+    @param path The path to move aside.
+
+    @return The new path.
+*/
+auto moveAside(const std::string& path) -> std::string;
+
+/**
+    @brief Moves a history or backup store that cannot be opened aside and reports it.
+
+    The store is moved with moveAside(), so the caller can start a new one without losing the old.
+
+    @param path The path of the store.
+    @param what The name of the store in the message, e.g. "History".
+    @param reason Why the store could not be opened.
+
+    @return The path the store was moved to.
+*/
+auto setAside(const std::string& path, const std::string& what, const std::string& reason) -> std::string;
+
+/**
+    @brief Replaces a file or directory with a staged copy in one step.
+
+    The two paths are exchanged with renameat2(RENAME_EXCHANGE) and the old content, now at the
+    staged path, is removed. An empty staged path does nothing.
+
+    @param staged The path of the new content.
+    @param path The path to replace; it must exist.
+
+    @return void
+
+    @throws std::runtime_error if the paths cannot be exchanged.
+*/
+auto replacePath(const std::string& staged, const std::string& path) -> void;
 
 
@@ -1,8 +1,58 @@
+#include <iostream>
+#include <string>
+#include <vector>
 #include "header.hpp"
 
-auto main() -> int {
+auto main(int argc, char* argv[]) -> int {
+    std::vector<std::string> args;
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--compress")
+            settings().compress = true;
+        else if (arg == "--folder" && i + 1 < argc)
+            settings().vaultFolder = argv[++i];
+        else
+            args.push_back(arg);
+    }
+    std::string mode = args.empty() ? "" : args[0];
+    if (!mode.empty() && !mode.starts_with("--"))
+        settings().vaultPath = mode;
 
-    fileRead();
+    try {
+        if (mode == "--multi") {
+            multiVaultRead();
+        } else if (mode == "--agent") {
+            auto idleTimeout = 900;
+            if (args.size() > 2 && args[1] == "--timeout")
+                idleTimeout = std::stoi(args[2]);
+            runAgent(selectFile(), idleTimeout);
+        } else if (mode == "--find") {
+            findCommand(args);
+        } else if (mode == "--merge") {
+            mergeCommand(args);
+        } else if (mode == "--bench-start" && args.size() > 1) {
+            startupBenchmark(args[1]);
+        } else if (mode == "--rekey" && args.size() > 3) {
+            return rekeyCommand(args);
+        } else if (mode == "--verify") {
+            return verifyCommand(args);
+        } else if (mode == "--audit") {
+            return auditCommand(args);
+        } else if (mode == "--build-word-graph" && args.size() > 2) {
+            buildWordGraph(std::vector<std::string>(args.begin() + 2, args.end()), args[1]);
+        } else if (mode == "--history") {
+            historyCommand(args);
+        } else if (mode == "--backup") {
+            backupCommand(args);
+        } else if (mode == "--query" && args.size() > 1) {
+            return agentQuery(args[1]);
+        } else {
+            fileRead();
+        }
+    } catch (const std::exception& e) {
+        std::cout << ">>> ERROR: " << e.what() << '\n';
+        return 1;
+    }
 
     return 0;
 }